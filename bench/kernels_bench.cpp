@@ -0,0 +1,223 @@
+// Micro-benchmark for the CPU kernels in src/PixelKernels.cpp, built without
+// openFrameworks by `make bench-kernels` (one binary per ISA level).
+//
+//   kernels_bench [--sizes 1080x2120,2160x3840] [--threads 1,2,4,8]
+//                 [--density 0.6] [--min-time 0.25]
+//
+// Every kernel runs on a fresh copy of the same synthetic frame; the copy is
+// not timed. Reports the median time per call, GB/s over the bytes the kernel
+// has to read and write, and ns per pixel (per particle for seeding). The
+// fused output kernel is checked byte for byte against the previous
+// mirror + un-premultiply code; a mismatch fails the run.
+
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef BENCH_ISA
+#define BENCH_ISA "default"
+#endif
+
+namespace {
+
+struct Options {
+	std::vector<std::pair<int, int>> sizes{{1080, 2120}, {2160, 3840}};
+	std::vector<int> threads{1, 2, 4, 8};
+	float density = 0.6f;  // particles per output pixel on width, app maximum
+	double minTime = 0.25; // seconds per measurement
+};
+
+struct Result {
+	double medianNs = 0.0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<std::string> split(const std::string &s, char sep){
+	std::vector<std::string> parts;
+	std::stringstream ss(s);
+	std::string part;
+	while(std::getline(ss, part, sep)) {
+		if(!part.empty()) parts.push_back(part);
+	}
+	return parts;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options){
+	for(int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if(i + 1 >= argc) {
+			std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+			return false;
+		}
+		std::string value = argv[++i];
+		if(arg == "--sizes") {
+			options.sizes.clear();
+			for(const auto &size : split(value, ',')) {
+				int w = 0, h = 0;
+				if(std::sscanf(size.c_str(), "%dx%d", &w, &h) != 2 || w < 2 || h < 2) {
+					std::fprintf(stderr, "bad size %s, expected WxH\n", size.c_str());
+					return false;
+				}
+				options.sizes.emplace_back(w, h);
+			}
+		} else if(arg == "--threads") {
+			options.threads.clear();
+			for(const auto &n : split(value, ',')) {
+				options.threads.push_back(std::max(1, std::atoi(n.c_str())));
+			}
+		} else if(arg == "--density") {
+			options.density = std::max(0.001f, float(std::atof(value.c_str())));
+		} else if(arg == "--min-time") {
+			options.minTime = std::max(0.01, std::atof(value.c_str()));
+		} else {
+			std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return false;
+		}
+	}
+	return !options.sizes.empty() && !options.threads.empty();
+}
+
+// runs prepare (untimed) + kernel (timed) until minTime has passed, at least 5 times
+Result measure(double minTime, const std::function<void()> &prepare, const std::function<void()> &kernel){
+	std::vector<double> samples;
+	double total = 0.0;
+	while(samples.size() < 5 || total < minTime) {
+		prepare();
+		auto start = Clock::now();
+		kernel();
+		double s = std::chrono::duration<double>(Clock::now() - start).count();
+		samples.push_back(s * 1e9);
+		total += s;
+	}
+	std::sort(samples.begin(), samples.end());
+	Result r;
+	r.medianNs = samples[samples.size() / 2];
+	return r;
+}
+
+void report(const char *kernel, int w, int h, int threads, size_t items, size_t bytes, const Result &r){
+	std::printf("%-22s %5dx%-5d %7d %9.3f %9.2f %8.3f\n", kernel, w, h, threads,
+		r.medianNs * 1e-6, double(bytes) / r.medianNs, r.medianNs / double(items));
+}
+
+// what the GPU composite looks like: mostly empty, soft premultiplied particles
+std::vector<uint8_t> makeOutputFrame(int w, int h){
+	std::vector<uint8_t> frame(size_t(w) * h * 4);
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> byte(0, 255);
+	for(size_t i = 0; i < frame.size(); i += 4) {
+		int roll = byte(rng);
+		uint8_t a = roll < 150 ? 0 : roll < 230 ? uint8_t(byte(rng)) : 255;
+		uint8_t c = a ? uint8_t(byte(rng) * a / 255) : 0;
+		frame[i + 0] = frame[i + 1] = frame[i + 2] = c;
+		frame[i + 3] = a;
+	}
+	return frame;
+}
+
+// the previous ofApp code: ofPixels::mirror(true, false), then a branchy
+// per-pixel un-premultiply
+void referenceOutput(uint8_t *data, int w, int h){
+	const size_t stride = size_t(w) * 4;
+	std::vector<uint8_t> tmp(stride);
+	for(int y = 0; y < h / 2; ++y) {
+		uint8_t *top = data + y * stride;
+		uint8_t *bottom = data + (h - 1 - y) * stride;
+		std::memcpy(tmp.data(), top, stride);
+		std::memcpy(top, bottom, stride);
+		std::memcpy(bottom, tmp.data(), stride);
+	}
+	const size_t total = stride * h;
+	for(size_t i = 0; i < total; i += 4) {
+		unsigned char a = data[i + 3];
+		if(a > 0 && a < 255) {
+			float invA = 255.0f / float(a);
+			data[i + 0] = std::min(255.0f, data[i + 0] * invA);
+			data[i + 1] = std::min(255.0f, data[i + 1] * invA);
+			data[i + 2] = std::min(255.0f, data[i + 2] * invA);
+		}
+		data[i + 3] = 255;
+	}
+}
+
+}
+
+//--------------------------------------------------------------
+int main(int argc, char *argv[]){
+	Options options;
+	if(!parseOptions(argc, argv, options)) {
+		std::fprintf(stderr, "usage: %s [--sizes WxH,...] [--threads N,...] [--density D] [--min-time S]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("isa %s, %u hardware threads\n", BENCH_ISA, std::thread::hardware_concurrency());
+	std::printf("%-22s %11s %7s %9s %9s %8s\n", "kernel", "size", "threads", "ms", "GB/s", "ns/px");
+
+	bool ok = true;
+	for(const auto &size : options.sizes) {
+		const int w = size.first, h = size.second;
+		const size_t pixels = size_t(w) * h;
+		const std::vector<uint8_t> source = makeOutputFrame(w, h);
+		std::vector<uint8_t> frame(source.size());
+		auto reload = [&]{ std::memcpy(frame.data(), source.data(), source.size()); };
+
+		// output path: flip + un-premultiply + alpha, in place (read + write)
+		std::vector<uint8_t> expected(source);
+		referenceOutput(expected.data(), w, h);
+		report("output_reference", w, h, 1, pixels, pixels * 8,
+			measure(options.minTime, reload, [&]{ referenceOutput(frame.data(), w, h); }));
+		for(int threads : options.threads) {
+			report("output_fused", w, h, threads, pixels, pixels * 8,
+				measure(options.minTime, reload, [&]{ PixelKernels::prepareOutput(frame.data(), w, h, threads); }));
+			if(frame != expected) {
+				std::printf("MISMATCH output_fused %dx%d, %d threads\n", w, h, threads);
+				ok = false;
+			}
+		}
+		// the same for the half-float composite of --format exr, read back as float
+		std::vector<float> floatSource(source.size()), floatFrame(source.size());
+		for(size_t i = 0; i < source.size(); ++i) {
+			floatSource[i] = source[i] * (1.0f / 255.0f);
+		}
+		auto reloadFloat = [&]{ std::memcpy(floatFrame.data(), floatSource.data(), floatSource.size() * sizeof(float)); };
+		for(int threads : options.threads) {
+			report("output_fused_float", w, h, threads, pixels, pixels * 32,
+				measure(options.minTime, reloadFloat, [&]{ PixelKernels::prepareOutput(floatFrame.data(), w, h, threads); }));
+		}
+		for(int threads : options.threads) {
+			report("flip", w, h, threads, pixels, pixels * 8,
+				measure(options.minTime, reload, [&]{ PixelKernels::flipRows(frame.data(), w, h, threads); }));
+		}
+		report("unpremultiply", w, h, 1, pixels, pixels * 8,
+			measure(options.minTime, reload, [&]{ PixelKernels::unpremultiply(frame.data(), pixels); }));
+
+		// particle seeding at the sim resolution ofApp::computeSimRes() picks
+		const int simW = std::max(200, int(w * options.density));
+		const int simH = std::max(300, int(float(simW) * float(h) / float(w)));
+		const size_t particles = size_t(simW) * simH;
+		std::vector<float> posVel(particles * 4), attr(particles * 4), posVelOne, attrOne;
+		for(int threads : options.threads) {
+			report("seed_particles", w, h, threads, particles, particles * 32,
+				measure(options.minTime, []{}, [&]{ PixelKernels::seedParticles(posVel.data(), attr.data(), simW, simH, 1, threads); }));
+			if(posVelOne.empty()) {
+				posVelOne = posVel;
+				attrOne = attr;
+			} else if(posVel != posVelOne || attr != attrOne) {
+				std::printf("MISMATCH seed_particles %dx%d, %d threads\n", simW, simH, threads);
+				ok = false;
+			}
+		}
+	}
+	return ok ? 0 : 1;
+}
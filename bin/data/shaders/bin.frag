@@ -0,0 +1,12 @@
+#version 150
+
+in vec4 vPosVel;
+
+// alpha 1 so OF_BLENDMODE_ADD accumulates exact sums
+out vec4 cellSum; // count, sum x, sum y (px)
+out vec4 cellVel; // sum vx, sum vy (px/s)
+
+void main(){
+    cellSum = vec4(1.0, vPosVel.xy, 1.0);
+    cellVel = vec4(vPosVel.zw, 0.0, 1.0);
+}
@@ -0,0 +1,30 @@
+#version 150
+
+// Neighbour grid pass: every particle is splatted as a single point onto its
+// grid cell. Additive blending turns the cell into running sums (count,
+// position, velocity) that update.frag reads back over the 3x3 neighbourhood.
+// Only these per-cell moments are kept, no per-cell particle lists, so the
+// interaction is a cell-average approximation rather than particle-particle.
+
+uniform sampler2D posTex;
+uniform vec2 screenRes;
+uniform vec2 gridRes;
+uniform float cellSize;
+
+in vec4 position;
+in vec2 texcoord;
+
+out vec4 vPosVel;
+
+void main(){
+    vec4 data = texture(posTex, texcoord);
+    vec2 p = data.xy * screenRes;
+    vec2 cell = floor(p / cellSize);
+    vPosVel = vec4(p, data.zw * screenRes);
+
+    bool inside = all(greaterThanEqual(cell, vec2(0.0))) && all(lessThan(cell, gridRes));
+    vec2 clip = (cell + 0.5) / gridRes * 2.0 - 1.0;
+    // off-canvas particles are dropped outside the viewport
+    gl_Position = inside ? vec4(clip, 0.0, 1.0) : vec4(-2.0, -2.0, 0.0, 1.0);
+    gl_PointSize = 1.0;
+}
@@ -2,6 +2,7 @@
 
 in vec2 vVel;
 in float vRand;
+in float vAge;
 out vec4 fragColor;
 
 uniform int renderSquares;
@@ -18,5 +19,7 @@ void main(){
         alpha = 1.0 - smoothstep(0.65, 1.0, length(circ));
         alpha *= 0.35 + vRand * 0.4;
     }
+    // fade in after (re)spawn instead of popping in
+    alpha *= smoothstep(0.0, 0.15, vAge);
     fragColor = vec4(vec3(shade), alpha);
 }
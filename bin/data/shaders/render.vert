@@ -1,8 +1,9 @@
 #version 150
 
 uniform sampler2D posTex;
+uniform sampler2D attrTex;
 uniform float pointSize;
-uniform float time;
+uniform int frame;
 uniform float shrinkStrength;
 uniform int renderSquares;
 
@@ -11,9 +12,13 @@ in vec2 texcoord;
 
 out vec2 vVel;
 out float vRand;
+out float vAge;
 
-float hash(vec2 p){
-    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
+// same generator as update.frag
+uint pcg(uint v){
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
 }
 
 void main(){
@@ -21,11 +26,15 @@ void main(){
     vec4 data = texture(posTex, uv);
     vec2 pos = data.xy;
     vVel = data.zw;
+    vec4 attr = texture(attrTex, uv);
 
     // small jitter to break banding
-    float j = (hash(uv + time) - 0.5) * 0.0045;
+    uint rng = pcg(uint(attr.r) ^ pcg(uint(frame) ^ 0x9e3779b9u));
+    float j = (float(rng >> 8) * (1.0 / 16777216.0) - 0.5) * 0.0045;
     pos.y += j;
-    vRand = hash(uv * 13.37 + time);
+    // per-particle, stable across frames
+    vRand = attr.a;
+    vAge = attr.g;
 
     // convert 0..1 to clip space, flip y correctly
     vec2 clip = vec2(pos.x * 2.0 - 1.0, (1.0 - pos.y) * 2.0 - 1.0);
@@ -1,6 +1,7 @@
 #version 150
 
 uniform sampler2D posTex;   // RG = pos, BA = vel
+uniform sampler2D attrTex;  // R = RNG key, G = age, B = flags/colour index, A = look variation
 uniform sampler2D maskTex;  // NDI mask
 uniform vec2 posRes;
 uniform vec2 screenRes;
@@ -12,21 +13,96 @@ uniform int collide;
 uniform int invertMask;
 uniform float topBias;
 uniform float bounceDampen;
-uniform float time;
+uniform int frame;         // simulation step, the RNG counter
 uniform float killFraction;
 uniform float bounceNoise;
 
+// neighbour interaction over the grid (see bin.vert). A cell-average
+// approximation, not particle-particle: every particle reacts to the count,
+// centroid and mean velocity of each of the 3x3 cells around it, never to
+// the individual particles inside them
+uniform int interact;
+uniform sampler2D gridSum;  // count, sum pos (px)
+uniform sampler2D gridVel;  // sum vel (px/s)
+uniform vec2 gridRes;
+uniform float cellSize;     // = interaction radius, px
+uniform float repulsion;
+uniform float cohesion;     // pull toward neighbour centroids
+uniform float alignment;    // velocity matching
+
 in vec2 vTexCoord;
 out vec4 fragColor;
+out vec4 attrColor;
+
+const uint FLAG_BOUNCED = 16u; // low 4 bits are the colour index
+
+// PCG output permutation: a few integer ops per draw, no trig, and the same
+// bits on every GPU
+uint pcg(uint v){
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// counter-based stream: key = per-particle RNG key (set from --seed at
+// spawn), counter = step
+uint rngInit(float key){
+    return pcg(uint(key) ^ pcg(uint(frame)));
+}
 
-float hash(vec2 p){
-    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
+float rand01(inout uint rng){
+    rng = pcg(rng);
+    return float(rng >> 8) * (1.0 / 16777216.0);
+}
+
+// against the centroids of the 3x3 neighbouring cells, in px/s^2: repulsion
+// inside one cell size, cohesion pulling in from half a cell to two cells
+// (zero in the core, peak at one cell) and alignment of velocities
+vec2 neighbourForce(vec2 pos, vec2 vel){
+    vec2 p = pos * screenRes;
+    vec2 v = vel * screenRes;
+    ivec2 cell = ivec2(floor(p / cellSize));
+    vec2 force = vec2(0.0);
+    for(int dy = -1; dy <= 1; ++dy){
+        for(int dx = -1; dx <= 1; ++dx){
+            ivec2 c = cell + ivec2(dx, dy);
+            if(any(lessThan(c, ivec2(0))) || any(greaterThanEqual(c, ivec2(gridRes)))) continue;
+            vec4 s = texelFetch(gridSum, c, 0);
+            vec2 sumV = texelFetch(gridVel, c, 0).xy;
+            float n = s.x;
+            vec2 sumP = s.yz;
+            if(c == cell){
+                // leave ourselves out
+                n -= 1.0;
+                sumP -= p;
+                sumV -= v;
+            }
+            if(n < 0.5) continue;
+
+            vec2 d = p - sumP / n;
+            float dist = length(d);
+            vec2 dir = dist > 1e-4 ? d / dist : vec2(0.0);
+            float w = max(0.0, 1.0 - dist / cellSize);
+            float pull = clamp((dist - 0.5 * cellSize) / (0.5 * cellSize), 0.0, 1.0)
+                       * clamp((2.0 * cellSize - dist) / cellSize, 0.0, 1.0);
+            force += dir * (repulsion * w * w - cohesion * pull) * n;
+            force += (sumV / n - v) * alignment * w;
+        }
+    }
+    return force;
 }
 
 void main(){
     vec4 data = texture(posTex, vTexCoord);
     vec2 pos = data.rg;
     vec2 vel = data.ba;
+    vec4 attr = texture(attrTex, vTexCoord);
+    float age = attr.g + dt;
+    uint flags = uint(attr.b);
+    uint rng = rngInit(attr.r);
+
+    // from the same state the grid was built from
+    vec2 nbForce = interact == 1 ? neighbourForce(pos, vel) / screenRes : vec2(0.0);
 
     float maskInfluence = 0.0;
     if(collide == 1){
@@ -37,39 +113,41 @@ void main(){
         maskInfluence = smoothstep(threshold, threshold + 0.1, lum);
     }
 
-    // gravity and drag
+    // gravity, neighbours and drag
     vel += vec2(0.0, gravity) * dt;
+    vel += nbForce * dt;
     vel *= 0.99;
 
     // turbulence
-    vec2 t = vec2(hash(vTexCoord * 3.17 + time),
-                  hash(vTexCoord * 5.31 - time)) - 0.5;
+    vec2 t = vec2(rand01(rng), rand01(rng)) - 0.5;
     vel += t * noiseStrength * 0.22;
 
     // jitter
-    float n = hash(vTexCoord + time * 1.3);
+    float n = rand01(rng);
     vel.x += (n - 0.5) * noiseStrength * dt;
-    vel.y += (hash(vTexCoord * 7.7 + time * 0.5) - 0.5) * noiseStrength * 0.04;
+    vel.y += (rand01(rng) - 0.5) * noiseStrength * 0.04;
 
     // bounce / splash on bright
     if(collide == 1 && maskInfluence > 0.5 && vel.y > 0.0){
-        float dieRoll = hash(vTexCoord * 19.37 + time * 0.21);
+        float dieRoll = rand01(rng);
         if(dieRoll < killFraction){
-            float r = hash(vTexCoord.yx * 3.17 + time);
+            float r = rand01(rng);
             float bias = mix(0.0, 0.25, topBias);
             pos = vec2(r, -0.05 + bias);
             vel = vec2(0.0, 0.0);
+            age = 0.0;
+            flags &= ~FLAG_BOUNCED;
         } else {
             float bounce = mix(0.35, 0.65, maskInfluence) * bounceDampen;
             vel.y *= -bounce;
-            float nn = hash(vTexCoord + time * 0.7);
+            float nn = rand01(rng);
             // add directional jitter to break continuous flows
-            vec2 scatter = vec2(hash(vTexCoord * 11.3 + time * 0.9),
-                                hash(vTexCoord * 15.7 - time * 0.4)) - 0.5;
+            vec2 scatter = vec2(rand01(rng), rand01(rng)) - 0.5;
             vel += scatter * bounceNoise * (0.4 + maskInfluence * 0.6);
             vel.x += (nn - 0.5) * (0.35 + maskInfluence * 0.5);
             vel.y += gravity * 0.5 * dt;
             pos.y = clamp(pos.y - 0.005, 0.0, 1.0);
+            flags |= FLAG_BOUNCED;
         }
     }
 
@@ -80,14 +158,16 @@ void main(){
     pos += vel * dt;
 
     // small offset to break rows
-    pos.y += (hash(vTexCoord * 9.1 + time * 0.9) - 0.5) * 0.0025;
+    pos.y += (rand01(rng) - 0.5) * 0.0025;
 
     // respawn at top if out of bounds
     if(pos.y > 1.02 || pos.y < -0.1){
-        float r = hash(vec2(vTexCoord.y * 1.37, time * 0.5));
+        float r = rand01(rng);
         float bias = mix(0.0, 0.25, topBias);
         pos = vec2(r, -0.05 + bias);
         vel = vec2(0.0, 0.0);
+        age = 0.0;
+        flags &= ~FLAG_BOUNCED;
     }
 
     // wrap x softly
@@ -95,4 +175,5 @@ void main(){
     if(pos.x > 1.05) pos.x = (pos.x - 1.05);
 
     fragColor = vec4(pos, vel);
+    attrColor = vec4(attr.r, age, float(flags), attr.a);
 }
@@ -0,0 +1,107 @@
+#include "AsyncReadback.h"
+
+//--------------------------------------------------------------
+AsyncReadback::~AsyncReadback(){
+	clear();
+}
+
+//--------------------------------------------------------------
+void AsyncReadback::allocate(int width, int height, size_t numBuffers, bool floatPixels){
+	clear();
+	width_ = width;
+	height_ = height;
+	float_ = floatPixels;
+	const size_t bytesPerChannel = float_ ? sizeof(float) : 1;
+	slots_.resize(std::max<size_t>(1, numBuffers));
+	for(auto &slot : slots_) {
+		slot.buffer.allocate(size_t(width) * height * 4 * bytesPerChannel, GL_STREAM_READ);
+	}
+}
+
+//--------------------------------------------------------------
+void AsyncReadback::clear(){
+	for(auto &slot : slots_) {
+		if(slot.fence) {
+			glDeleteSync(slot.fence);
+			slot.fence = nullptr;
+		}
+	}
+	slots_.clear();
+	head_ = 0;
+	count_ = 0;
+	width_ = 0;
+	height_ = 0;
+}
+
+//--------------------------------------------------------------
+void AsyncReadback::push(const ofTexture &tex){
+	if(slots_.empty()) return;
+	if(count_ == slots_.size()) {
+		// caller didn't drain; drop the oldest rather than block
+		ofLogWarning("AsyncReadback") << "all buffers in flight, dropping a frame";
+		glDeleteSync(slots_[head_].fence);
+		slots_[head_].fence = nullptr;
+		head_ = (head_ + 1) % slots_.size();
+		--count_;
+	}
+	auto &slot = slots_[(head_ + count_) % slots_.size()];
+	if(float_) {
+		// copyTo() picks the pixel type from the internal format, which for
+		// RGBA16F isn't GL_FLOAT everywhere; ask for floats explicitly
+		const auto &data = tex.getTextureData();
+		slot.buffer.bind(GL_PIXEL_PACK_BUFFER);
+		glBindTexture(data.textureTarget, data.textureID);
+		glGetTexImage(data.textureTarget, 0, GL_RGBA, GL_FLOAT, 0);
+		glBindTexture(data.textureTarget, 0);
+		slot.buffer.unbind(GL_PIXEL_PACK_BUFFER);
+	} else {
+		tex.copyTo(slot.buffer);
+	}
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	++count_;
+}
+
+//--------------------------------------------------------------
+bool AsyncReadback::pop(ofPixels &pixels, bool wait){
+	if(float_) {
+		ofLogError("AsyncReadback") << "allocated for float pixels";
+		return false;
+	}
+	return popInto(pixels, wait);
+}
+
+//--------------------------------------------------------------
+bool AsyncReadback::pop(ofFloatPixels &pixels, bool wait){
+	if(!float_) {
+		ofLogError("AsyncReadback") << "allocated for 8-bit pixels";
+		return false;
+	}
+	return popInto(pixels, wait);
+}
+
+//--------------------------------------------------------------
+template<typename PixelType>
+bool AsyncReadback::popInto(ofPixels_<PixelType> &pixels, bool wait){
+	if(count_ == 0) return false;
+	auto &slot = slots_[head_];
+
+	bool mustRetire = wait || count_ == slots_.size();
+	GLuint64 timeout = mustRetire ? GL_TIMEOUT_IGNORED : 0;
+	GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if(status == GL_TIMEOUT_EXPIRED) return false;
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	if(!pixels.isAllocated() || int(pixels.getWidth()) != width_ || int(pixels.getHeight()) != height_ || pixels.getNumChannels() != 4) {
+		pixels.allocate(width_, height_, OF_PIXELS_RGBA);
+	}
+	auto *src = slot.buffer.map<PixelType>(GL_READ_ONLY);
+	if(src) {
+		std::memcpy(pixels.getData(), src, pixels.getTotalBytes());
+	}
+	slot.buffer.unmap();
+
+	head_ = (head_ + 1) % slots_.size();
+	--count_;
+	return src != nullptr;
+}
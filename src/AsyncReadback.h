@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Ring of pixel pack buffers for reading textures back without stalling the
+// GPU. push() queues a copy and returns immediately; pop() hands back the
+// oldest frame once its copy has landed, so readback overlaps the next frames.
+class AsyncReadback {
+	public:
+		~AsyncReadback();
+
+		// floatPixels reads back RGBA float (for half-float textures) instead of RGBA8
+		void allocate(int width, int height, size_t numBuffers = 3, bool floatPixels = false);
+		void clear();
+		bool isAllocated() const { return !slots_.empty(); }
+		bool isFloat() const { return float_; }
+		int getWidth() const { return width_; }
+		int getHeight() const { return height_; }
+		size_t pending() const { return count_; }
+
+		// tex must be RGBA (RGBA16F/32F when allocated for float) and match
+		// the allocated size
+		void push(const ofTexture &tex);
+		// without wait, only returns a frame whose copy is done (or when every
+		// buffer is in flight and the oldest has to be retired). The pixel
+		// type has to match the allocation
+		bool pop(ofPixels &pixels, bool wait);
+		bool pop(ofFloatPixels &pixels, bool wait);
+
+	private:
+		template<typename PixelType>
+		bool popInto(ofPixels_<PixelType> &pixels, bool wait);
+
+		struct Slot {
+			ofBufferObject buffer;
+			GLsync fence = nullptr;
+		};
+
+		std::vector<Slot> slots_;
+		size_t head_ = 0;  // oldest pending slot
+		size_t count_ = 0;
+		int width_ = 0;
+		int height_ = 0;
+		bool float_ = false;
+};
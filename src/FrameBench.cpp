@@ -0,0 +1,127 @@
+#include "FrameBench.h"
+
+//--------------------------------------------------------------
+bool FrameBench::setup(const std::string &configPath){
+	if(!ofFile::doesFileExist(configPath)) {
+		ofLogError("FrameBench") << "bench config not found: " << configPath;
+		return false;
+	}
+	ofJson j = ofLoadJson(configPath);
+	warmupFrames_ = j.value("warmup_frames", warmupFrames_);
+	measureFrames_ = std::max(1, j.value("frames", measureFrames_));
+	tolerance_ = j.value("tolerance", tolerance_);
+	minDeltaMs_ = j.value("min_delta_ms", minDeltaMs_);
+
+	cases_.clear();
+	auto interactModes = j.value("interact", ofJson::array({false}));
+	for(const auto &size : j.value("sizes", ofJson::array())) {
+		int w = 0, h = 0;
+		if(!size.is_string() || std::sscanf(size.get<std::string>().c_str(), "%dx%d", &w, &h) != 2) {
+			ofLogError("FrameBench") << "bad size " << size.dump() << ", expected \"WxH\"";
+			return false;
+		}
+		for(const auto &density : j.value("densities", ofJson::array())) {
+			for(const auto &interact : interactModes) {
+				Case c;
+				c.width = w;
+				c.height = h;
+				c.density = density.get<float>();
+				c.interact = interact.get<bool>();
+				c.name = size.get<std::string>() + "@" + ofToString(c.density) + (c.interact ? "+nb" : "");
+				cases_.push_back(c);
+			}
+		}
+	}
+	if(cases_.empty()) {
+		ofLogError("FrameBench") << "no cases in " << configPath << " (needs sizes and densities)";
+		return false;
+	}
+	ofLogNotice("FrameBench") << cases_.size() << " cases, " << warmupFrames_ << " warmup + " << measureFrames_ << " frames each";
+	return true;
+}
+
+//--------------------------------------------------------------
+void FrameBench::addResult(const Case &benchCase, glm::ivec2 simRes, const StageTimer &timer, const ofJson &extra){
+	ofJson r = extra.is_object() ? extra : ofJson::object();
+	r["name"] = benchCase.name;
+	r["width"] = benchCase.width;
+	r["height"] = benchCase.height;
+	r["density"] = benchCase.density;
+	r["interact"] = benchCase.interact;
+	r["particles"] = simRes.x * simRes.y;
+	r["stages"] = timer.summary();
+	results_.push_back(r);
+
+	const auto &total = r["stages"]["total"];
+	ofLogNotice("FrameBench") << benchCase.name << " (" << simRes.x * simRes.y << " particles): median "
+		<< ofToString(total.value("median_ms", 0.0f), 2) << " ms, p95 " << ofToString(total.value("p95_ms", 0.0f), 2) << " ms";
+}
+
+//--------------------------------------------------------------
+bool FrameBench::finish(const std::string &outPath, const std::string &baselinePath, bool updateBaseline){
+	std::string renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+
+	ofJson out;
+	out["gl_renderer"] = renderer;
+	out["gl_version"] = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+	out["tolerance"] = tolerance_;
+	out["cases"] = results_;
+
+	ofJson regressions = ofJson::array();
+	for(const auto &result : results_) {
+		if(result.contains("neighbour_check") && !result["neighbour_check"].value("ok", false)) {
+			ofJson reg;
+			reg["case"] = result["name"];
+			reg["stage"] = "neighbour_check";
+			regressions.push_back(reg);
+			ofLogError("FrameBench") << "GPU neighbour grid doesn't match the CPU reference in " << result["name"].get<std::string>();
+		}
+	}
+	// one baseline per GL renderer: medians from a GPU box and from llvmpipe
+	// can't be compared with each other
+	ofJson baselines = ofFile::doesFileExist(baselinePath) ? ofLoadJson(baselinePath) : ofJson::object();
+	if(!baselines.is_object() || !baselines.contains("renderers")) {
+		baselines = ofJson::object();
+		baselines["renderers"] = ofJson::object();
+	}
+	bool haveBaseline = baselines["renderers"].contains(renderer);
+	if(!haveBaseline) {
+		ofLogNotice("FrameBench") << "no baseline for '" << renderer << "' in " << baselinePath << ", not comparing";
+	}
+	if(haveBaseline && !updateBaseline) {
+		const ofJson &baseline = baselines["renderers"][renderer];
+		for(const auto &result : results_) {
+			auto base = std::find_if(baseline["cases"].begin(), baseline["cases"].end(), [&](const ofJson &c){
+				return c.value("name", "") == result["name"];
+			});
+			if(base == baseline["cases"].end()) continue;
+
+			for(const auto &stage : result["stages"].items()) {
+				if(!(*base)["stages"].contains(stage.key())) continue;
+				float now = stage.value().value("median_ms", 0.0f);
+				float was = (*base)["stages"][stage.key()].value("median_ms", 0.0f);
+				if(now > was * (1.0f + tolerance_) && now - was > minDeltaMs_) {
+					ofJson reg;
+					reg["case"] = result["name"];
+					reg["stage"] = stage.key();
+					reg["baseline_ms"] = was;
+					reg["median_ms"] = now;
+					regressions.push_back(reg);
+					ofLogError("FrameBench") << "REGRESSION " << result["name"].get<std::string>() << " " << stage.key()
+						<< ": " << ofToString(was, 3) << " -> " << ofToString(now, 3) << " ms";
+				}
+			}
+		}
+	}
+	out["regressions"] = regressions;
+
+	ofSavePrettyJson(outPath, out);
+	ofLogNotice("FrameBench") << "results: " << outPath;
+	if(updateBaseline || !haveBaseline) {
+		baselines["renderers"][renderer] = out;
+		ofSavePrettyJson(baselinePath, baselines);
+		ofLogNotice("FrameBench") << (haveBaseline ? "baseline updated for '" : "baseline recorded for '")
+			<< renderer << "': " << baselinePath;
+	}
+	return regressions.empty();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ofMain.h"
+#include "StageTimer.h"
+
+// Case list, results and baseline check for --bench. Every case runs the real
+// update()/draw() pipeline at one output size and particle density; the
+// per-stage medians are then compared against the baseline stored for the
+// same GL renderer.
+class FrameBench {
+	public:
+		struct Case {
+			std::string name; // "1080x2120@0.15", "+nb" with interaction
+			int width = 0;
+			int height = 0;
+			float density = 0.0f;
+			bool interact = false; // neighbour grid stage on
+		};
+
+		bool setup(const std::string &configPath);
+		const std::vector<Case> & getCases() const { return cases_; }
+		int getWarmupFrames() const { return warmupFrames_; }
+		int getMeasureFrames() const { return measureFrames_; }
+		void setTolerance(float tolerance) { tolerance_ = tolerance; }
+
+		void addResult(const Case &benchCase, glm::ivec2 simRes, const StageTimer &timer, const ofJson &extra = ofJson());
+		// writes results to outPath; returns false when a stage regressed
+		bool finish(const std::string &outPath, const std::string &baselinePath, bool updateBaseline);
+
+	private:
+		std::vector<Case> cases_;
+		int warmupFrames_ = 30;
+		int measureFrames_ = 240;
+		float tolerance_ = 0.15f;   // allowed slowdown over baseline median
+		float minDeltaMs_ = 0.05f;  // ignore jitter on near-empty stages
+		ofJson results_ = ofJson::array();
+};
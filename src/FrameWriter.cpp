@@ -0,0 +1,121 @@
+#include "FrameWriter.h"
+
+#include <fstream>
+
+//--------------------------------------------------------------
+FrameWriter::~FrameWriter(){
+	finish();
+}
+
+//--------------------------------------------------------------
+bool FrameWriter::setup(const std::string &dir, const std::string &format, size_t numThreads, size_t maxQueued){
+	finish();
+
+	ofDirectory outDir(dir);
+	if(!outDir.exists() && !outDir.create(true)) {
+		ofLogError("FrameWriter") << "can't create output folder " << dir;
+		return false;
+	}
+	dir_ = dir;
+	format_ = format;
+	written_ = 0;
+	failed_ = 0;
+
+	if(numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	maxQueued_ = maxQueued > 0 ? maxQueued : numThreads * 2;
+	stopping_ = false;
+	for(size_t i = 0; i < numThreads; ++i) {
+		workers_.emplace_back(&FrameWriter::workerLoop, this);
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+void FrameWriter::write(ofPixels &&pixels, size_t index){
+	Job job;
+	job.pixels = std::move(pixels);
+	job.index = index;
+	push(std::move(job));
+}
+
+//--------------------------------------------------------------
+void FrameWriter::write(ofFloatPixels &&pixels, size_t index){
+	Job job;
+	job.floatPixels = std::move(pixels);
+	job.index = index;
+	push(std::move(job));
+}
+
+//--------------------------------------------------------------
+void FrameWriter::push(Job &&job){
+	std::unique_lock<std::mutex> lock(mutex_);
+	hasRoom_.wait(lock, [&]{ return queue_.size() < maxQueued_; });
+	queue_.push_back(std::move(job));
+	lock.unlock();
+	hasWork_.notify_one();
+}
+
+//--------------------------------------------------------------
+void FrameWriter::finish(){
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	hasWork_.notify_all();
+	for(auto &worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+//--------------------------------------------------------------
+void FrameWriter::workerLoop(){
+	while(true) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		hasWork_.wait(lock, [&]{ return stopping_ || !queue_.empty(); });
+		if(queue_.empty()) return; // stopping and drained
+		Job job = std::move(queue_.front());
+		queue_.pop_front();
+		lock.unlock();
+		hasRoom_.notify_one();
+
+		if(job.floatPixels.isAllocated()) {
+			if(prepareFloat_) prepareFloat_(job.floatPixels);
+		} else if(prepare_) {
+			prepare_(job.pixels);
+		}
+		if(encode(job)) {
+			++written_;
+		} else {
+			++failed_;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+bool FrameWriter::encode(Job &job){
+	std::string ext = format_ == "raw" ? "rgba" : format_;
+	auto path = ofFilePath::join(dir_, "frame_" + ofToString(job.index, 6, '0') + "." + ext);
+
+	bool ok = true;
+	if(format_ == "raw") {
+		std::ofstream out(path, std::ios::binary);
+		out.write(reinterpret_cast<const char *>(job.pixels.getData()), job.pixels.size());
+		ok = out.good();
+	} else if(format_ == "exr") {
+		if(job.floatPixels.isAllocated()) {
+			ok = ofSaveImage(job.floatPixels, path);
+		} else {
+			ofLogError("FrameWriter") << "exr needs float frames";
+			ok = false;
+		}
+	} else {
+		ok = ofSaveImage(job.pixels, path);
+	}
+	if(!ok) {
+		ofLogError("FrameWriter") << "failed to write " << path;
+	}
+	return ok;
+}
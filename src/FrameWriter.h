@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Thread pool that post-processes and encodes rendered frames to disk so the
+// render loop never waits on PNG/EXR compression. write() only blocks when
+// the queue is full, which caps memory when encoding is the bottleneck.
+class FrameWriter {
+	public:
+		~FrameWriter();
+
+		// format: png | exr | raw (raw = tightly packed RGBA8, no header).
+		// exr takes float frames, the others 8-bit ones
+		bool setup(const std::string &dir, const std::string &format, size_t numThreads, size_t maxQueued = 0);
+		// runs on the worker before encoding (flip, un-premultiply...)
+		void setPrepare(std::function<void(ofPixels &)> prepare) { prepare_ = std::move(prepare); }
+		void setPrepareFloat(std::function<void(ofFloatPixels &)> prepare) { prepareFloat_ = std::move(prepare); }
+
+		void write(ofPixels &&pixels, size_t index);
+		void write(ofFloatPixels &&pixels, size_t index);
+		// waits for queued frames and stops the workers
+		void finish();
+
+		size_t framesWritten() const { return written_; }
+		size_t framesFailed() const { return failed_; }
+		size_t numThreads() const { return workers_.size(); }
+
+	private:
+		struct Job {
+			ofPixels pixels;
+			ofFloatPixels floatPixels; // exr
+			size_t index;
+		};
+
+		void push(Job &&job);
+		void workerLoop();
+		bool encode(Job &job);
+
+		std::string dir_;
+		std::string format_;
+		std::function<void(ofPixels &)> prepare_;
+		std::function<void(ofFloatPixels &)> prepareFloat_;
+
+		std::vector<std::thread> workers_;
+		std::deque<Job> queue_;
+		std::mutex mutex_;
+		std::condition_variable hasWork_;
+		std::condition_variable hasRoom_;
+		size_t maxQueued_ = 0;
+		bool stopping_ = false;
+		std::atomic<size_t> written_{0};
+		std::atomic<size_t> failed_{0};
+};
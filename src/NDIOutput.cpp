@@ -0,0 +1,103 @@
+#include "NDIOutput.h"
+
+//--------------------------------------------------------------
+std::vector<NDIOutput::Settings> NDIOutput::loadSettings(const std::string &path, const std::string &defaultName){
+	std::vector<Settings> outputs;
+	if(ofFile::doesFileExist(path)) {
+		ofJson j = ofLoadJson(path);
+		for(const auto &o : j.value("outputs", ofJson::array())) {
+			Settings s;
+			s.name = o.value("name", "");
+			s.scale = ofClamp(o.value("scale", 1.0f), 0.05f, 1.0f);
+			s.divisor = std::max(1, o.value("divisor", 1));
+			s.enabled = o.value("enabled", true);
+			if(s.name.empty()) {
+				ofLogWarning("NDIOutput") << "output without a name in " << path << ", skipped";
+				continue;
+			}
+			if(s.enabled) outputs.push_back(s);
+		}
+	}
+	if(outputs.empty()) {
+		Settings s;
+		s.name = defaultName;
+		outputs.push_back(s);
+	}
+	return outputs;
+}
+
+//--------------------------------------------------------------
+bool NDIOutput::setupSender(){
+	if(!sender_.setup(settings_.name)) return false;
+	video_.setup(sender_);
+	video_.setAsync(true);
+	sending_ = true;
+	return true;
+}
+
+//--------------------------------------------------------------
+void NDIOutput::resize(int compositeWidth, int compositeHeight){
+	// scaled outputs get even sizes; some NDI receivers reject odd widths
+	int w = compositeWidth, h = compositeHeight;
+	if(needsMipmaps()) {
+		w = std::max(2, int(std::round(compositeWidth * settings_.scale / 2.0f)) * 2);
+		h = std::max(2, int(std::round(compositeHeight * settings_.scale / 2.0f)) * 2);
+	}
+	if(w == width_ && h == height_ && readback_.isAllocated()) return;
+	width_ = w;
+	height_ = h;
+
+	if(needsMipmaps()) {
+		ofFbo::Settings s;
+		s.width = width_;
+		s.height = height_;
+		s.internalformat = GL_RGBA;
+		s.useDepth = false;
+		s.useStencil = false;
+		s.textureTarget = GL_TEXTURE_2D;
+		s.minFilter = GL_LINEAR;
+		s.maxFilter = GL_LINEAR;
+		s.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
+		s.wrapModeVertical = GL_CLAMP_TO_EDGE;
+		scaled_.allocate(s);
+	} else {
+		scaled_.clear();
+	}
+	readback_.allocate(width_, height_);
+	ofLogNotice("NDIOutput") << settings_.name << ": " << width_ << " x " << height_ << ", every " << settings_.divisor << " frame(s)";
+}
+
+//--------------------------------------------------------------
+void NDIOutput::capture(const ofTexture &composite){
+	if(!readback_.isAllocated()) return;
+	if(!needsMipmaps()) {
+		readback_.push(composite);
+		return;
+	}
+	// trilinear from the composite mipmaps: a box filter at power-of-two
+	// scales, and no full-size intermediate
+	scaled_.begin();
+	ofClear(0,0,0,0);
+	ofPushStyle();
+	ofDisableBlendMode();
+	ofSetColor(255);
+	composite.draw(0, 0, width_, height_);
+	ofPopStyle();
+	scaled_.end();
+	readback_.push(scaled_.getTexture());
+}
+
+//--------------------------------------------------------------
+void NDIOutput::send(){
+	if(sending_) {
+		video_.send(pixels_);
+	}
+}
+
+//--------------------------------------------------------------
+void NDIOutput::clear(){
+	readback_.clear();
+	scaled_.clear();
+	width_ = 0;
+	height_ = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxNDISender.h"
+#include "ofxNDISendStream.h"
+#include "AsyncReadback.h"
+
+// One NDI stream cut from the shared composite. Smaller outputs are drawn
+// from the composite's mipmaps into their own FBO, so a 1/4 preview reads
+// back and sends 1/16 of the pixels; every output has its own readback
+// ring and sender and only captures on its frame-rate divisor.
+class NDIOutput {
+	public:
+		struct Settings {
+			std::string name;
+			float scale = 1.0f;  // of the composite size
+			int divisor = 1;     // send every Nth frame
+			bool enabled = true;
+		};
+
+		// reads {"outputs": [{name, scale, divisor, enabled}, ...]}; falls back
+		// to a single full-size output named defaultName
+		static std::vector<Settings> loadSettings(const std::string &path, const std::string &defaultName);
+
+		explicit NDIOutput(const Settings &settings) : settings_(settings) {}
+
+		const Settings & getSettings() const { return settings_; }
+		// fails when the NDI sender can't be created; ofApp only captures
+		// outputs without a sender under --bench
+		bool setupSender();
+		bool isSending() const { return sending_; }
+		bool needsMipmaps() const { return settings_.scale < 1.0f; }
+		int getWidth() const { return width_; }
+		int getHeight() const { return height_; }
+
+		// resizes the downsample target and readback ring for a new composite size
+		void resize(int compositeWidth, int compositeHeight);
+		bool wantsFrame(uint64_t frame) const { return frame % uint64_t(settings_.divisor) == 0; }
+		// downsample (if scaled) and queue the async readback
+		void capture(const ofTexture &composite);
+		// takes the oldest frame whose copy has landed, if any, into getPixels()
+		bool receive() { return readback_.pop(pixels_, false); }
+		ofPixels & getPixels() { return pixels_; }
+		void send();
+		void clear();
+
+	private:
+		Settings settings_;
+		int width_ = 0;
+		int height_ = 0;
+		ofFbo scaled_;
+		AsyncReadback readback_;
+		ofPixels pixels_; // reused every frame, the NDI sender copies it
+		ofxNDISender sender_;
+		ofxNDISendVideo video_;
+		bool sending_ = false;
+};
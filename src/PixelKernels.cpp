@@ -0,0 +1,191 @@
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// un-premultiplied value for every (alpha, colour) pair, 64 KB. Filled with
+// the float math of the old per-pixel branch (a == 0 and a == 255 keep their
+// colour), so the bytes out are the same; a lookup per channel beats the
+// division and the branch, which mispredicts on soft particle edges.
+struct UnpremultiplyTable {
+	uint8_t value[256][256];
+
+	UnpremultiplyTable(){
+		for(int a = 0; a < 256; ++a) {
+			const float invA = (a == 0 || a == 255) ? 1.0f : 255.0f / float(a);
+			for(int c = 0; c < 256; ++c) {
+				value[a][c] = uint8_t(std::min(255.0f, c * invA));
+			}
+		}
+	}
+};
+
+const UnpremultiplyTable & unpremultiplyTable(){
+	static const UnpremultiplyTable table;
+	return table;
+}
+
+inline void unpremultiplyPixel(const UnpremultiplyTable &table, const uint8_t *in, uint8_t *out){
+	const uint8_t *row = table.value[in[3]];
+	out[0] = row[in[0]];
+	out[1] = row[in[1]];
+	out[2] = row[in[2]];
+	out[3] = 255;
+}
+
+void swapUnpremultiplyRows(const UnpremultiplyTable &table, uint8_t *__restrict top, uint8_t *__restrict bottom, int width){
+	for(int x = 0; x < width * 4; x += 4) {
+		uint8_t t[4], b[4];
+		unpremultiplyPixel(table, top + x, t);
+		unpremultiplyPixel(table, bottom + x, b);
+		std::memcpy(top + x, b, 4);
+		std::memcpy(bottom + x, t, 4);
+	}
+}
+
+// float version of the above, clamped the same way as the byte table
+inline void unpremultiplyPixel(const float *in, float *out){
+	const float a = in[3];
+	if(a > 0.0f && a < 1.0f) {
+		const float invA = 1.0f / a;
+		out[0] = std::min(1.0f, in[0] * invA);
+		out[1] = std::min(1.0f, in[1] * invA);
+		out[2] = std::min(1.0f, in[2] * invA);
+	} else {
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+	}
+	out[3] = 1.0f;
+}
+
+void swapUnpremultiplyRows(float *__restrict top, float *__restrict bottom, int width){
+	for(int x = 0; x < width * 4; x += 4) {
+		float t[4], b[4];
+		unpremultiplyPixel(top + x, t);
+		unpremultiplyPixel(bottom + x, b);
+		std::memcpy(top + x, b, sizeof(b));
+		std::memcpy(bottom + x, t, sizeof(t));
+	}
+}
+
+// PCG output permutation, identical to the one in update.frag / render.vert
+inline uint32_t pcg(uint32_t v){
+	uint32_t state = v * 747796405u + 2891336453u;
+	uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+inline float rand01(uint32_t &rng){
+	rng = pcg(rng);
+	return float(rng >> 8) * (1.0f / 16777216.0f);
+}
+
+}
+
+namespace PixelKernels {
+
+//--------------------------------------------------------------
+void forRows(int rows, int numThreads, const std::function<void(int, int)> &fn){
+	numThreads = std::max(1, std::min(numThreads, rows));
+	if(numThreads == 1) {
+		fn(0, rows);
+		return;
+	}
+	std::vector<std::thread> workers;
+	workers.reserve(numThreads - 1);
+	for(int t = 0; t < numThreads - 1; ++t) {
+		workers.emplace_back(fn, rows * t / numThreads, rows * (t + 1) / numThreads);
+	}
+	fn(rows * (numThreads - 1) / numThreads, rows);
+	for(auto &worker : workers) {
+		worker.join();
+	}
+}
+
+//--------------------------------------------------------------
+void prepareOutput(uint8_t *rgba, int width, int height, int numThreads){
+	const size_t stride = size_t(width) * 4;
+	const auto &table = unpremultiplyTable();
+	forRows(height / 2, numThreads, [&](int y0, int y1){
+		for(int y = y0; y < y1; ++y) {
+			swapUnpremultiplyRows(table, rgba + y * stride, rgba + (height - 1 - y) * stride, width);
+		}
+	});
+	if(height % 2) {
+		unpremultiply(rgba + (height / 2) * stride, width);
+	}
+}
+
+//--------------------------------------------------------------
+void prepareOutput(float *rgba, int width, int height, int numThreads){
+	const size_t stride = size_t(width) * 4;
+	forRows(height / 2, numThreads, [&](int y0, int y1){
+		for(int y = y0; y < y1; ++y) {
+			swapUnpremultiplyRows(rgba + y * stride, rgba + (height - 1 - y) * stride, width);
+		}
+	});
+	if(height % 2) {
+		float *row = rgba + (height / 2) * stride;
+		for(size_t x = 0; x < stride; x += 4) {
+			unpremultiplyPixel(row + x, row + x);
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void flipRows(uint8_t *rgba, int width, int height, int numThreads){
+	const size_t stride = size_t(width) * 4;
+	forRows(height / 2, numThreads, [&](int y0, int y1){
+		std::vector<uint8_t> tmp(stride);
+		for(int y = y0; y < y1; ++y) {
+			uint8_t *top = rgba + y * stride;
+			uint8_t *bottom = rgba + (height - 1 - y) * stride;
+			std::memcpy(tmp.data(), top, stride);
+			std::memcpy(top, bottom, stride);
+			std::memcpy(bottom, tmp.data(), stride);
+		}
+	});
+}
+
+//--------------------------------------------------------------
+void unpremultiply(uint8_t *rgba, size_t numPixels){
+	const auto &table = unpremultiplyTable();
+	for(size_t i = 0; i < numPixels * 4; i += 4) {
+		uint8_t out[4];
+		unpremultiplyPixel(table, rgba + i, out);
+		std::memcpy(rgba + i, out, 4);
+	}
+}
+
+//--------------------------------------------------------------
+void seedParticles(float *posVel, float *attr, int width, int height, uint32_t seed, int numThreads){
+	const uint32_t key = pcg(seed);
+	forRows(height, numThreads, [&](int y0, int y1){
+		for(int y = y0; y < y1; ++y) {
+			for(int x = 0; x < width; ++x) {
+				const uint32_t index = uint32_t(y) * width + x;
+				// per-particle RNG key for the shaders, depends on the run seed;
+				// 24 bits so it stays exact in a float
+				uint32_t rng = pcg(index ^ key);
+				const uint32_t particleKey = rng >> 8;
+				float *p = posVel + size_t(index) * 4;
+				float *a = attr + size_t(index) * 4;
+				p[0] = rand01(rng);
+				p[1] = rand01(rng) * 0.1f - 0.05f; // start near top
+				p[2] = (rand01(rng) * 2.0f - 1.0f) * 0.005f;
+				p[3] = 0.0f;
+				a[0] = float(particleKey);
+				a[1] = 0.0f;
+				a[2] = float(int(rand01(rng) * 4.0f)); // colour index, no flags
+				a[3] = rand01(rng);
+			}
+		}
+	});
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Per-pixel CPU work of the app, kept free of openFrameworks so bench/ can
+// build and time it on its own. Loops are plain scalar code written to
+// auto-vectorize, so the ISA is whatever the translation unit is built for.
+namespace PixelKernels {
+
+	// splits [0, rows) into numThreads contiguous ranges, the last one runs
+	// on the calling thread
+	void forRows(int rows, int numThreads, const std::function<void(int, int)> &fn);
+
+	// flip rows (GL bottom-up -> top-left origin), un-premultiply colour and
+	// force alpha to 255, in one pass over tightly packed RGBA8
+	void prepareOutput(uint8_t *rgba, int width, int height, int numThreads = 1);
+	// the same for RGBA float frames read back from a half-float composite
+	// (EXR output), alpha forced to 1
+	void prepareOutput(float *rgba, int width, int height, int numThreads = 1);
+
+	// the same two steps separately, for pixels that are already top-down
+	void flipRows(uint8_t *rgba, int width, int height, int numThreads = 1);
+	void unpremultiply(uint8_t *rgba, size_t numPixels);
+
+	// initial particle state in the posTex/attrTex layouts (RGBA floats):
+	// random x, y near the top, small sideways drift; RNG key (24 bits, from
+	// seed and particle index), age 0, colour index 0..3, look variation
+	// 0..1. Uses the same PCG generator as the shaders, so it's deterministic
+	// and splits by rows.
+	void seedParticles(float *posVel, float *attr, int width, int height, uint32_t seed, int numThreads = 1);
+
+}
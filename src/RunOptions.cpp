@@ -0,0 +1,160 @@
+#include "RunOptions.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+namespace {
+
+// paths given on the command line are relative to the shell, not to bin/data
+std::string absolutePath(const std::string &path){
+	if(path.empty()) return path;
+	return std::filesystem::absolute(path).lexically_normal().string();
+}
+
+bool parseSize(const std::string &value, int &w, int &h){
+	return std::sscanf(value.c_str(), "%dx%d", &w, &h) == 2 && w > 0 && h > 0;
+}
+
+}
+
+//--------------------------------------------------------------
+bool parseRunOptions(int argc, char *argv[], RunOptions &options, std::string &error){
+	for(int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		auto value = [&](std::string &out){
+			if(i + 1 >= argc) {
+				error = "missing value for " + arg;
+				return false;
+			}
+			out = argv[++i];
+			return true;
+		};
+		std::string v;
+
+		if(arg == "--offline") {
+			options.mode = RunOptions::Mode::Offline;
+		} else if(arg == "--bench") {
+			options.mode = RunOptions::Mode::Bench;
+		} else if(arg == "--bench-config") {
+			if(!value(v)) return false;
+			options.benchConfig = absolutePath(v);
+		} else if(arg == "--baseline") {
+			if(!value(v)) return false;
+			options.baselinePath = absolutePath(v);
+		} else if(arg == "--bench-out") {
+			if(!value(v)) return false;
+			options.benchOut = absolutePath(v);
+		} else if(arg == "--update-baseline") {
+			options.updateBaseline = true;
+		} else if(arg == "--tolerance") {
+			if(!value(v)) return false;
+			options.tolerance = std::strtof(v.c_str(), nullptr);
+		} else if(arg == "--headless") {
+			options.headless = true;
+		} else if(arg == "--size") {
+			if(!value(v)) return false;
+			if(!parseSize(v, options.width, options.height)) {
+				error = "invalid --size '" + v + "', expected WxH";
+				return false;
+			}
+		} else if(arg == "--masks") {
+			if(!value(v)) return false;
+			options.maskPath = absolutePath(v);
+		} else if(arg == "--settings") {
+			if(!value(v)) return false;
+			options.settingsPath = absolutePath(v);
+		} else if(arg == "--out") {
+			if(!value(v)) return false;
+			options.outDir = absolutePath(v);
+		} else if(arg == "--format") {
+			if(!value(v)) return false;
+			if(v != "png" && v != "exr" && v != "raw") {
+				error = "invalid --format '" + v + "', expected png, exr or raw";
+				return false;
+			}
+			options.format = v;
+		} else if(arg == "--dt" || arg == "--fps") {
+			if(!value(v)) return false;
+			float f = std::strtof(v.c_str(), nullptr);
+			if(f <= 0.0f) {
+				error = "invalid " + arg + " '" + v + "'";
+				return false;
+			}
+			options.dt = arg == "--fps" ? 1.0f / f : f;
+		} else if(arg == "--frames") {
+			if(!value(v)) return false;
+			options.frames = std::max(0, std::atoi(v.c_str()));
+		} else if(arg == "--threads") {
+			if(!value(v)) return false;
+			options.encoderThreads = std::max(0, std::atoi(v.c_str()));
+		} else if(arg == "--seed") {
+			if(!value(v)) return false;
+			options.seed = static_cast<unsigned int>(std::strtoul(v.c_str(), nullptr, 10));
+		} else if(arg == "--help" || arg == "-h") {
+			error = "";
+			return false;
+		} else if(arg.rfind("-psn_", 0) == 0) {
+			// process serial number passed by Finder on macOS
+		} else {
+			error = "unknown argument '" + arg + "'";
+			return false;
+		}
+	}
+
+	if(options.isOffline()) {
+		if(options.outDir.empty()) {
+			options.outDir = absolutePath("render");
+		}
+		if(options.maskPath.empty() && options.frames == 0) {
+			error = "--offline needs --masks or --frames";
+			return false;
+		}
+	}
+	if(options.isBench() && options.benchOut.empty()) {
+		options.benchOut = absolutePath("bench_results.json");
+	}
+#if defined(__linux__)
+	// render nodes and CI boxes have no display; EGL works with or without one
+	if(!options.isLive()) {
+		options.headless = true;
+	}
+#endif
+	return true;
+}
+
+//--------------------------------------------------------------
+std::string runOptionsUsage(){
+	std::ostringstream ss;
+	ss << "usage: NEXT2VISUALS [options]\n"
+	   << "\n"
+	   << "  --size WxH          canvas / output size (default 1080x2120)\n"
+	   << "  --headless          offscreen EGL context, no window (Linux)\n"
+	   << "\n"
+	   << "offline render:\n"
+	   << "  --offline           render to image files instead of running live\n"
+	   << "  --masks PATH        mask image folder (sorted by name) or video file\n"
+	   << "  --settings FILE     GUI settings xml (default data/settings.xml)\n"
+	   << "  --out DIR           output folder (default ./render)\n"
+	   << "  --format FMT        png | exr | raw (default png); exr is composed and\n"
+	   << "                      read back in half float, png and raw in 8 bits\n"
+	   << "  --dt SECONDS        fixed simulation step (default 1/60)\n"
+	   << "  --fps N             same as --dt 1/N\n"
+	   << "  --frames N          frames to render (default: one per mask frame); past\n"
+	   << "                      the end of the masks the last one stays up, for\n"
+	   << "                      image folders and videos alike\n"
+	   << "  --threads N         encoder threads (default: all cores)\n"
+	   << "  --seed N            particle seed (default 1)\n"
+	   << "\n"
+	   << "frame-time bench:\n"
+	   << "  --bench             run the pipeline over the bench cases, report JSON\n"
+	   << "  --bench-config FILE sizes/densities/frames (default data/bench/cases.json)\n"
+	   << "  --baseline FILE     baseline to compare against (default data/bench/baseline.json)\n"
+	   << "  --bench-out FILE    results (default ./bench_results.json)\n"
+	   << "  --update-baseline   overwrite this GL renderer's baseline with this run\n"
+	   << "  --tolerance F       allowed slowdown, 0.15 = 15% (default from config)\n"
+	   << "  --masks, --settings and --seed apply as for --offline\n";
+	return ss.str();
+}
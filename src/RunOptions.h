@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+// Command line configuration. With no arguments the app runs live (NDI in,
+// NDI out, GUI, vsync) exactly as before.
+struct RunOptions {
+	enum class Mode {
+		Live,
+		Offline, // fixed-dt render of a mask sequence to image files
+		Bench,   // frame-time regression run over a set of sizes/densities
+	};
+
+	Mode mode = Mode::Live;
+	int width = 1080;
+	int height = 2120;
+	bool headless = false; // offscreen EGL context (Linux only)
+
+	// offline render
+	std::string maskPath;     // image sequence folder or video file
+	std::string settingsPath; // empty = data/settings.xml
+	std::string outDir;       // empty = ./render
+	std::string format = "png"; // png | exr | raw
+	float dt = 1.0f / 60.0f;
+	int frames = 0;           // 0 = one frame per mask frame
+	int encoderThreads = 0;   // 0 = hardware concurrency
+	unsigned int seed = 1;
+
+	// bench (masks come from maskPath when set, synthetic otherwise)
+	std::string benchConfig;  // empty = data/bench/cases.json
+	std::string baselinePath; // empty = data/bench/baseline.json
+	std::string benchOut;     // empty = ./bench_results.json
+	bool updateBaseline = false;
+	float tolerance = -1.0f;  // < 0 = value from the bench config
+
+	bool isLive() const { return mode == Mode::Live; }
+	bool isOffline() const { return mode == Mode::Offline; }
+	bool isBench() const { return mode == Mode::Bench; }
+};
+
+bool parseRunOptions(int argc, char *argv[], RunOptions &options, std::string &error);
+std::string runOptionsUsage();
@@ -0,0 +1,125 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+void SpatialHash::cellCoords(size_t i, int &cx, int &cy) const{
+	float px = posVel_[i * 4 + 0] * screenW_;
+	float py = posVel_[i * 4 + 1] * screenH_;
+	cx = int(std::floor(px / cellSize_));
+	cy = int(std::floor(py / cellSize_));
+}
+
+//--------------------------------------------------------------
+int SpatialHash::cellOf(size_t i) const{
+	int cx, cy;
+	cellCoords(i, cx, cy);
+	if(cx < 0 || cy < 0 || cx >= gridW_ || cy >= gridH_) return -1;
+	return cy * gridW_ + cx;
+}
+
+//--------------------------------------------------------------
+void SpatialHash::build(const float *posVel, size_t count, float screenW, float screenH, float cellSize){
+	posVel_ = posVel;
+	count_ = count;
+	screenW_ = screenW;
+	screenH_ = screenH;
+	cellSize_ = std::max(1.0f, cellSize);
+	gridW_ = int(std::ceil(screenW / cellSize_));
+	gridH_ = int(std::ceil(screenH / cellSize_));
+	const size_t numCells = size_t(gridW_) * gridH_;
+
+	// count
+	cellCount_.assign(numCells, 0);
+	particleCell_.resize(count);
+	for(size_t i = 0; i < count; ++i) {
+		int c = cellOf(i);
+		particleCell_[i] = c;
+		if(c >= 0) ++cellCount_[c];
+	}
+
+	// exclusive prefix sum -> cell offsets
+	cellStart_.resize(numCells);
+	uint32_t running = 0;
+	for(size_t c = 0; c < numCells; ++c) {
+		cellStart_[c] = running;
+		running += cellCount_[c];
+	}
+
+	// scatter, stable in particle order
+	sorted_.resize(running);
+	std::vector<uint32_t> cursor(cellStart_);
+	for(size_t i = 0; i < count; ++i) {
+		int c = particleCell_[i];
+		if(c >= 0) sorted_[cursor[c]++] = uint32_t(i);
+	}
+}
+
+//--------------------------------------------------------------
+void SpatialHash::cellMoments(std::vector<float> &sum0, std::vector<float> &sum1) const{
+	const size_t numCells = cellCount_.size();
+	sum0.assign(numCells * 4, 0.0f);
+	sum1.assign(numCells * 4, 0.0f);
+	for(size_t c = 0; c < numCells; ++c) {
+		float *s0 = &sum0[c * 4];
+		float *s1 = &sum1[c * 4];
+		for(uint32_t k = cellStart_[c]; k < cellStart_[c] + cellCount_[c]; ++k) {
+			const float *p = posVel_ + size_t(sorted_[k]) * 4;
+			s0[1] += p[0] * screenW_;
+			s0[2] += p[1] * screenH_;
+			s1[0] += p[2] * screenW_;
+			s1[1] += p[3] * screenH_;
+		}
+		s0[0] = s0[3] = s1[3] = float(cellCount_[c]);
+	}
+}
+
+//--------------------------------------------------------------
+void SpatialHash::computeForces(float repulsion, float cohesion, float alignment, std::vector<float> &forces) const{
+	std::vector<float> sum0, sum1;
+	cellMoments(sum0, sum1);
+
+	forces.assign(count_ * 2, 0.0f);
+	for(size_t i = 0; i < count_; ++i) {
+		const int cell = particleCell_[i];
+		const float *d = posVel_ + i * 4;
+		float px = d[0] * screenW_, py = d[1] * screenH_;
+		float vx = d[2] * screenW_, vy = d[3] * screenH_;
+		int cx, cy;
+		cellCoords(i, cx, cy);
+
+		float fx = 0.0f, fy = 0.0f;
+		for(int dy = -1; dy <= 1; ++dy) {
+			for(int dx = -1; dx <= 1; ++dx) {
+				int nx = cx + dx, ny = cy + dy;
+				if(nx < 0 || ny < 0 || nx >= gridW_ || ny >= gridH_) continue;
+				size_t c = size_t(ny) * gridW_ + nx;
+				float n = sum0[c * 4];
+				float sx = sum0[c * 4 + 1], sy = sum0[c * 4 + 2];
+				float svx = sum1[c * 4], svy = sum1[c * 4 + 1];
+				if(int(c) == cell) {
+					// leave ourselves out
+					n -= 1.0f;
+					sx -= px; sy -= py;
+					svx -= vx; svy -= vy;
+				}
+				if(n < 0.5f) continue;
+
+				float ox = px - sx / n, oy = py - sy / n;
+				float dist = std::sqrt(ox * ox + oy * oy);
+				float inv = dist > 1e-4f ? 1.0f / dist : 0.0f;
+				float w = std::max(0.0f, 1.0f - dist / cellSize_);
+				float pull = std::min(1.0f, std::max(0.0f, (dist - 0.5f * cellSize_) / (0.5f * cellSize_)))
+					* std::min(1.0f, std::max(0.0f, (2.0f * cellSize_ - dist) / cellSize_));
+				float radial = (repulsion * w * w - cohesion * pull) * n;
+				fx += ox * inv * radial;
+				fy += oy * inv * radial;
+				fx += (svx / n - vx) * alignment * w;
+				fy += (svy / n - vy) * alignment * w;
+			}
+		}
+		forces[i * 2 + 0] = fx;
+		forces[i * 2 + 1] = fy;
+	}
+}
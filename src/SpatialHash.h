@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU reference for the particle neighbour stage. Builds a uniform grid with a
+// counting sort (count -> exclusive prefix -> scatter) and evaluates the same
+// cell-moment forces as update.frag; ofApp::checkNeighbourGrid() compares
+// both the GPU grid and the velocity change of one GPU step against it.
+// Like the shader, it's a cell-average approximation: particles react to the
+// centroid and mean velocity of each neighbouring cell, not to each other.
+//
+// Positions come in the posTex layout: RGBA floats, xy = 0..1 canvas position,
+// zw = velocity in canvas units per second. Forces are in px/s^2.
+class SpatialHash {
+	public:
+		void build(const float *posVel, size_t count, float screenW, float screenH, float cellSize);
+
+		int gridWidth() const { return gridW_; }
+		int gridHeight() const { return gridH_; }
+
+		// per cell, same layout as the GPU grid targets:
+		// sum0 = (count, sum x px, sum y px, count), sum1 = (sum vx px, sum vy px, 0, count)
+		void cellMoments(std::vector<float> &sum0, std::vector<float> &sum1) const;
+
+		// repulsion, cohesion (pull toward centroids) and alignment (velocity
+		// matching) over the 3x3 neighbouring cells, one vec2 per particle.
+		// Like the shader, particles just off the canvas still feel the cells
+		// next to them
+		void computeForces(float repulsion, float cohesion, float alignment, std::vector<float> &forces) const;
+
+	private:
+		void cellCoords(size_t i, int &cx, int &cy) const;
+		int cellOf(size_t i) const;
+
+		const float *posVel_ = nullptr;
+		size_t count_ = 0;
+		float screenW_ = 0.0f;
+		float screenH_ = 0.0f;
+		float cellSize_ = 1.0f;
+		int gridW_ = 0;
+		int gridH_ = 0;
+
+		std::vector<uint32_t> cellCount_;
+		std::vector<uint32_t> cellStart_;
+		std::vector<uint32_t> sorted_;
+		std::vector<int> particleCell_; // -1 = off canvas
+};
@@ -0,0 +1,72 @@
+#include "StageTimer.h"
+
+namespace {
+
+float elapsedMs(std::chrono::steady_clock::time_point from){
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+ofJson stats(std::vector<float> samples){
+	ofJson j;
+	if(samples.empty()) return j;
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for(float s : samples) sum += s;
+	auto at = [&](float q){ return samples[std::min(samples.size() - 1, size_t(q * (samples.size() - 1) + 0.5f))]; };
+	j["mean_ms"] = sum / samples.size();
+	j["median_ms"] = at(0.5f);
+	j["p95_ms"] = at(0.95f);
+	j["max_ms"] = samples.back();
+	j["samples"] = samples.size();
+	return j;
+}
+
+}
+
+//--------------------------------------------------------------
+void StageTimer::beginFrame(){
+	if(!enabled_) return;
+	glFinish();
+	frameStart_ = Clock::now();
+}
+
+//--------------------------------------------------------------
+void StageTimer::endFrame(){
+	if(!enabled_) return;
+	glFinish();
+	if(recording_) {
+		totals_.push_back(elapsedMs(frameStart_));
+	}
+}
+
+//--------------------------------------------------------------
+void StageTimer::reset(){
+	stages_.clear();
+	totals_.clear();
+}
+
+//--------------------------------------------------------------
+void StageTimer::begin(){
+	if(!enabled_) return;
+	glFinish();
+	stageStart_ = Clock::now();
+}
+
+//--------------------------------------------------------------
+void StageTimer::end(const char *stage){
+	if(!enabled_) return;
+	glFinish();
+	if(recording_) {
+		stages_[stage].push_back(elapsedMs(stageStart_));
+	}
+}
+
+//--------------------------------------------------------------
+ofJson StageTimer::summary() const{
+	ofJson j;
+	for(const auto &stage : stages_) {
+		j[stage.first] = stats(stage.second);
+	}
+	j["total"] = stats(totals_);
+	return j;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <chrono>
+#include <map>
+
+// Per-stage CPU+GPU frame timing for the --bench harness. While enabled each
+// stage is fenced with glFinish so GPU work is charged to the stage that
+// issued it; disabled (live) every call is a no-op.
+class StageTimer {
+	public:
+		class Scope {
+			public:
+				Scope(StageTimer &timer, const char *stage) : timer_(timer), stage_(stage) { timer_.begin(); }
+				~Scope() { timer_.end(stage_); }
+				Scope(const Scope &) = delete;
+				Scope & operator=(const Scope &) = delete;
+			private:
+				StageTimer &timer_;
+				const char *stage_;
+		};
+
+		void setEnabled(bool enabled) { enabled_ = enabled; }
+		bool isEnabled() const { return enabled_; }
+		void setRecording(bool recording) { recording_ = recording; }
+
+		Scope scope(const char *stage) { return Scope(*this, stage); }
+		void beginFrame();
+		void endFrame();
+		void reset();
+
+		size_t numFrames() const { return totals_.size(); }
+		// {stage: {mean_ms, median_ms, p95_ms, max_ms}, ..., "total": {...}}
+		ofJson summary() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		void begin();
+		void end(const char *stage);
+
+		bool enabled_ = false;
+		bool recording_ = false;
+		Clock::time_point frameStart_;
+		Clock::time_point stageStart_;
+		std::map<std::string, std::vector<float>> stages_;
+		std::vector<float> totals_;
+};
@@ -1,18 +1,42 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "ofAppEGLHeadlessWindow.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char *argv[]){
+
+	RunOptions options;
+	std::string error;
+	if(!parseRunOptions(argc, argv, options, error)) {
+		if(!error.empty()) {
+			std::cerr << error << "\n\n";
+		}
+		std::cerr << runOptionsUsage();
+		return error.empty() ? 0 : 1;
+	}
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
-	ofGLWindowSettings settings;
-	settings.setSize(1080, 2120); // vertical canvas target area
+	ofGLFWWindowSettings settings;
+	settings.setSize(options.width, options.height); // vertical canvas target area
 	settings.setGLVersion(3, 2); // core profile for shaders (#version 150)
 	settings.windowMode = OF_WINDOW; // can also be OF_FULLSCREEN
+	settings.visible = !options.isOffline(); // offline renders only into FBOs
 
-	auto window = ofCreateWindow(settings);
+	std::shared_ptr<ofAppBaseWindow> window;
+#if defined(TARGET_LINUX) && !defined(TARGET_OPENGLES)
+	if(options.headless) {
+		ofInit();
+		auto headless = std::make_shared<ofAppEGLHeadlessWindow>();
+		ofGetMainLoop()->addWindow(headless);
+		headless->setup(settings);
+		window = headless;
+	}
+#endif
+	if(!window) {
+		window = ofCreateWindow(settings);
+	}
 
-	ofRunApp(window, make_shared<ofApp>());
-	ofRunMainLoop();
+	ofRunApp(window, make_shared<ofApp>(options));
+	return ofRunMainLoop();
 
 }
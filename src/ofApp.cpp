@@ -1,24 +1,69 @@
 #include "ofApp.h"
 
+namespace {
+
+// load a shader with several fragment outputs; GLSL 150 has no layout
+// qualifiers, so output slots have to be bound before linking
+bool loadShaderMRT(ofShader &shader, const std::string &name, std::initializer_list<const char *> outputs){
+	if(!shader.setupShaderFromFile(GL_VERTEX_SHADER, name + ".vert")) return false;
+	if(!shader.setupShaderFromFile(GL_FRAGMENT_SHADER, name + ".frag")) return false;
+	shader.bindDefaults();
+	GLuint slot = 0;
+	for(auto output : outputs) {
+		glBindFragDataLocation(shader.getProgram(), slot++, output);
+	}
+	return shader.linkProgram();
+}
+
+// flip for NDI / image files (both expect top-left origin), un-premultiply
+// colors and force alpha to 255 to avoid dimming on receivers
+void prepareOutputPixels(ofPixels &pix){
+	if(pix.getNumChannels() != 4) {
+		pix.mirror(true, false);
+		return;
+	}
+	PixelKernels::prepareOutput(pix.getData(), pix.getWidth(), pix.getHeight());
+}
+
+// same for the float frames of --format exr
+void prepareOutputFloatPixels(ofFloatPixels &pix){
+	PixelKernels::prepareOutput(pix.getData(), pix.getWidth(), pix.getHeight());
+}
+
+}
+
 //--------------------------------------------------------------
 void ofApp::setup(){
 	ofDisableArbTex(); // use normalized coords for GLSL sampling
-	NDIlib_initialize();
-	ofSetVerticalSync(true);
-	ofSetFrameRate(60);
+	if(!options_.isLive()) {
+		// step as fast as the hardware allows; pacing comes from the fixed dt
+		ofSetVerticalSync(false);
+		ofSetFrameRate(0);
+		ofSeedRandom(options_.seed);
+		showGui_ = false;
+		sendNDI_ = false;
+		if(options_.isOffline() && options_.format == "exr") {
+			// trail and composite in half float, so exr frames carry more
+			// than the 8 bits a png gets
+			canvasFormat_ = GL_RGBA16F;
+		}
+	} else {
+		NDIlib_initialize();
+		ofSetVerticalSync(true);
+		ofSetFrameRate(60);
+	}
 	ofBackground(0);
 
 	ensureDataFolder();
 	computeSimRes();
-	loadSavedSource();
-	finder_.watchSources();
+	if(options_.isLive()) {
+		loadSavedSource();
+		finder_.watchSources();
+	}
 	ofLogNotice("NEXT2VISUALS") << "data path: " << ofToDataPath("", true);
 	setupCascade();
-	if(ndiSender_.setup(ndiName_)) {
-		ndiVideo_.setup(ndiSender_);
-		ndiVideo_.setAsync(true);
-		ndiReady_ = true;
-		ofLogNotice("NEXT2VISUALS") << "NDI output ready: " << ndiName_;
+	if(!options_.isOffline()) {
+		setupOutputs();
 	}
 
 	gui_.setup("NEXT2VISUALS");
@@ -38,6 +83,11 @@ void ofApp::setup(){
 	pInvertMask_.set("invert mask", invertMask_);
 	pShowMask_.set("show mask", showMask_);
 	pRenderSquares_.set("render squares", renderSquares_);
+	pInteract_.set("interact", interact_);
+	pInteractRadius_.set("interact radius", interactRadius_, 2.0f, 24.0f);
+	pRepulsion_.set("repulsion", repulsion_, 0.0f, 2000.0f);
+	pCohesion_.set("cohesion", cohesion_, 0.0f, 500.0f);
+	pAlignment_.set("alignment", alignment_, 0.0f, 20.0f);
 	gui_.add(pGravity_);
 	gui_.add(pNoise_);
 	gui_.add(pThreshold_);
@@ -54,11 +104,18 @@ void ofApp::setup(){
 	gui_.add(pInvertMask_);
 	gui_.add(pShowMask_);
 	gui_.add(pRenderSquares_);
-
-	// load saved GUI settings if present
-	auto settingsPath = ofToDataPath("settings.xml", true);
-	if(ofFile::doesFileExist(settingsPath)) {
-		gui_.loadFromFile("settings.xml");
+	gui_.add(pInteract_);
+	gui_.add(pInteractRadius_);
+	gui_.add(pRepulsion_);
+	gui_.add(pCohesion_);
+	gui_.add(pAlignment_);
+
+	// load saved GUI settings if present (bench runs on defaults unless told,
+	// the saved file changes whenever an operator tweaks the show)
+	auto settingsPath = options_.settingsPath.empty() ? ofToDataPath("settings.xml", true) : options_.settingsPath;
+	bool loadSettings = !options_.isBench() || !options_.settingsPath.empty();
+	if(loadSettings && ofFile::doesFileExist(settingsPath)) {
+		gui_.loadFromFile(settingsPath);
 		// sync params after load
 		gravity_ = pGravity_;
 		noiseStrength_ = pNoise_;
@@ -67,20 +124,66 @@ void ofApp::setup(){
 		simDensity_ = pSimDensity_;
 		topBias_ = pTopBias_;
 		bounceDampen_ = pBounceDampen_;
+		bounceNoise_ = pBounceNoise_;
 		shrinkStrength_ = pShrinkStrength_;
 		maskAlpha_ = pMaskAlpha_;
 		trailFade_ = pTrailFade_;
+		killFraction_ = pKillFraction_;
 		collide_ = pCollide_;
 		invertMask_ = pInvertMask_;
 		showMask_ = pShowMask_;
 		renderSquares_ = pRenderSquares_;
+		interact_ = pInteract_;
+		interactRadius_ = pInteractRadius_;
+		repulsion_ = pRepulsion_;
+		cohesion_ = pCohesion_;
+		alignment_ = pAlignment_;
 		computeSimRes();
 		rebuildCascade();
+	} else if(!options_.settingsPath.empty()) {
+		ofLogWarning("NEXT2VISUALS") << "settings not found: " << settingsPath << ", using defaults";
+	}
+
+	if(options_.isOffline() && !setupOffline()) {
+		ofExit(1);
+	}
+	if(options_.isBench() && !setupBench()) {
+		ofExit(1);
 	}
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
+	if(options_.isOffline()) {
+		if(offlineDone_) return;
+		if(fetchMask(offlineFrame_)) {
+			uploadMask(pixels_);
+		} else if(maskFailed_) {
+			offlineDone_ = true;
+			ofExit(1);
+			return;
+		}
+		updateParticles(options_.dt);
+		return;
+	}
+	if(options_.isBench()) {
+		if(benchCase_ < 0) return;
+		bool recorded = fetchMask(benchFrame_);
+		if(maskFailed_) {
+			benchCase_ = -1;
+			ofExit(1);
+			return;
+		}
+		if(!recorded) {
+			makeSyntheticMask(benchFrame_);
+		}
+		// mask decode/generation stays outside the measured frame
+		stageTimer_.beginFrame();
+		uploadMask(recorded ? pixels_ : syntheticMask_);
+		updateParticles(options_.dt);
+		return;
+	}
+
 	auto sources = finder_.getSources();
 
 	if(!receiver_.isConnected()) {
@@ -117,11 +220,7 @@ void ofApp::update(){
 		if(video_.isFrameNew()) {
 			video_.decodeTo(pixels_);
 			if(pixels_.isAllocated()) {
-				if(!texture_.isAllocated() || texture_.getWidth() != pixels_.getWidth() || texture_.getHeight() != pixels_.getHeight()) {
-					texture_.allocate(pixels_);
-				}
-				texture_.loadData(pixels_);
-				hasFrame_ = true;
+				uploadMask(pixels_);
 				// draw occupies full window
 				maskDrawRect_.set(0, 0, ofGetWidth(), ofGetHeight());
 				if(!particlesReady_) {
@@ -149,6 +248,11 @@ void ofApp::update(){
 			invertMask_ = pInvertMask_;
 			showMask_ = pShowMask_;
 			renderSquares_ = pRenderSquares_;
+			interact_ = pInteract_;
+			interactRadius_ = pInteractRadius_;
+			repulsion_ = pRepulsion_;
+			cohesion_ = pCohesion_;
+			alignment_ = pAlignment_;
 			float newDensity = pSimDensity_;
 			if(fabs(newDensity - simDensity_) > 0.005f) {
 				simDensity_ = newDensity;
@@ -173,6 +277,11 @@ void ofApp::update(){
 			pShowMask_ = showMask_;
 			pSimDensity_ = simDensity_;
 			pRenderSquares_ = renderSquares_;
+			pInteract_ = interact_;
+			pInteractRadius_ = interactRadius_;
+			pRepulsion_ = repulsion_;
+			pCohesion_ = cohesion_;
+			pAlignment_ = alignment_;
 		}
 
 		updateParticles(ofGetLastFrameTime());
@@ -183,22 +292,39 @@ void ofApp::update(){
 void ofApp::draw(){
 	ofBackground(0);
 
+	if(options_.isOffline()) {
+		drawOffline();
+		return;
+	}
+	if(options_.isBench()) {
+		drawBench();
+		return;
+	}
+
 	if(particlesReady_) {
 		ensureTrailFbo();
 		ensureOutputFbo();
+		updateTrail();
+	}
+	drawScreen();
 
-		// update trail FBO with cascade
-		trailFbo_.begin();
+	// compose and send NDI output (only cascade, no GUI/trail/mask)
+	if(ndiReady_ && sendNDI_) {
+		publishOutput();
+	}
+
+	if(showGui_) {
 		ofPushStyle();
-		ofEnableBlendMode(OF_BLENDMODE_ALPHA);
-		ofSetColor(0, 0, 0, static_cast<int>(trailFade_ * 255));
-		ofDrawRectangle(0, 0, trailFbo_.getWidth(), trailFbo_.getHeight());
 		ofSetColor(255);
-		drawCascade();
-		ofDisableBlendMode();
+		gui_.draw();
 		ofPopStyle();
-		trailFbo_.end();
+	}
+}
 
+//--------------------------------------------------------------
+void ofApp::drawScreen(){
+	auto timed = stageTimer_.scope("screen");
+	if(particlesReady_) {
 		// draw trail to screen (upright)
 		ofSetColor(255);
 		trailFbo_.getTexture().draw(0, ofGetHeight(), ofGetWidth(), -ofGetHeight());
@@ -240,48 +366,6 @@ void ofApp::draw(){
 			ofDrawBitmapStringHighlight(ofToString(i+1) + ": " + src.p_ndi_name, 20, 140 + i * 20);
 		}
 	}
-
-
-	// compose and send NDI output (only cascade, no GUI/trail/mask)
-	if(ndiReady_ && sendNDI_) {
-		outputFbo_.begin();
-		ofClear(0,0,0,0); // keep transparency
-		ofSetColor(255);
-		// draw trail
-		ofEnableBlendMode(OF_BLENDMODE_ALPHA);
-		trailFbo_.draw(0, 0, outputFbo_.getWidth(), outputFbo_.getHeight());
-		// draw fresh cascade on top
-		drawCascade();
-		ofDisableBlendMode();
-		outputFbo_.end();
-		ofPixels sendPix;
-		outputFbo_.readToPixels(sendPix);
-		// flip for NDI (NDI expects top-left origin)
-		sendPix.mirror(true, false);
-		// un-premultiply colors and force alpha to 255 to avoid dimming on receivers
-		if(sendPix.getNumChannels() == 4) {
-			auto *data = sendPix.getData();
-			const size_t total = sendPix.size();
-			for(size_t i = 0; i < total; i += 4) {
-				unsigned char a = data[i + 3];
-				if(a > 0 && a < 255) {
-					float invA = 255.0f / float(a);
-					data[i + 0] = std::min(255.0f, data[i + 0] * invA);
-					data[i + 1] = std::min(255.0f, data[i + 1] * invA);
-					data[i + 2] = std::min(255.0f, data[i + 2] * invA);
-				}
-				data[i + 3] = 255;
-			}
-		}
-		ndiVideo_.send(sendPix);
-	}
-
-	if(showGui_) {
-		ofPushStyle();
-		ofSetColor(255);
-		gui_.draw();
-		ofPopStyle();
-	}
 }
 
 //--------------------------------------------------------------
@@ -290,6 +374,11 @@ void ofApp::exit(){
 		receiver_.disconnect();
 	}
 
+	if(!options_.isLive()) {
+		frameWriter_.finish();
+		return;
+	}
+
 	if(showGui_) {
 		gui_.saveToFile("settings.xml");
 	}
@@ -454,7 +543,7 @@ void ofApp::ensureTrailFbo(){
 	ofFbo::Settings s;
 	s.width = ofGetWidth();
 	s.height = ofGetHeight();
-	s.internalformat = GL_RGBA;
+	s.internalformat = canvasFormat_;
 	s.useDepth = false;
 	s.useStencil = false;
 	s.textureTarget = GL_TEXTURE_2D;
@@ -478,7 +567,7 @@ void ofApp::ensureOutputFbo(){
 	ofFbo::Settings s;
 	s.width = ofGetWidth();
 	s.height = ofGetHeight();
-	s.internalformat = GL_RGBA;
+	s.internalformat = canvasFormat_;
 	s.useDepth = false;
 	s.useStencil = false;
 	s.textureTarget = GL_TEXTURE_2D;
@@ -490,6 +579,10 @@ void ofApp::ensureOutputFbo(){
 	outputFbo_.begin();
 	ofClear(0,0,0,255);
 	outputFbo_.end();
+	if(outputsNeedMipmaps_) {
+		// scaled outputs sample the mip chain built in publishOutput()
+		outputFbo_.getTexture().setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
+	}
 }
 
 //--------------------------------------------------------------
@@ -499,9 +592,10 @@ void ofApp::setupCascade(){
 
 	// load shaders once
 	if(!shadersLoaded_) {
-		bool updOk = updateShader_.load("shaders/update");
+		bool updOk = loadShaderMRT(updateShader_, "shaders/update", {"fragColor", "attrColor"});
 		bool rndOk = renderShader_.load("shaders/render");
-		shadersLoaded_ = updOk && rndOk;
+		bool binOk = loadShaderMRT(binShader_, "shaders/bin", {"cellSum", "cellVel"});
+		shadersLoaded_ = updOk && rndOk && binOk;
 		if(!shadersLoaded_) {
 			ofLogError("NEXT2VISUALS") << "Shaders failed to load.";
 			return;
@@ -534,10 +628,11 @@ void ofApp::rebuildCascade(){
 	s.maxFilter = GL_NEAREST;
 	s.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
 	s.wrapModeVertical = GL_CLAMP_TO_EDGE;
+	s.numColorbuffers = 2; // 0 = pos/vel, 1 = RNG key/age/flags/variation
 
 	for(auto &fbo : ping_) {
 		fbo.allocate(s);
-		fbo.begin(); ofClear(0,0,0,0); fbo.end();
+		fbo.begin(); fbo.activateAllDrawBuffers(); ofClear(0,0,0,0); fbo.end();
 	}
 
 	particleMesh_.setMode(OF_PRIMITIVE_POINTS);
@@ -557,23 +652,17 @@ void ofApp::rebuildCascade(){
 
 //--------------------------------------------------------------
 void ofApp::initParticles(){
-	ofFloatPixels pix;
+	ofFloatPixels pix, attr;
 	pix.allocate(simRes_.x, simRes_.y, 4);
-	for(int y=0; y<simRes_.y; ++y){
-		for(int x=0; x<simRes_.x; ++x){
-			float fx = ofRandom(1.0f);
-			float fy = ofRandom(-0.05f, 0.05f); // start near top
-			float vx = ofRandomf() * 0.005f;
-			float vy = 0.0f;
-			int idx = (y * simRes_.x + x) * 4;
-			pix[idx + 0] = fx;
-			pix[idx + 1] = fy;
-			pix[idx + 2] = vx;
-			pix[idx + 3] = vy;
-		}
-	}
-	ping_[0].getTexture().loadData(pix);
-	ping_[1].getTexture().loadData(pix);
+	attr.allocate(simRes_.x, simRes_.y, 4);
+	// one draw from ofRandom keeps --seed in charge of the layout and of the
+	// per-particle RNG keys the shaders run from
+	uint32_t seed = uint32_t(ofRandom(16777216.0f));
+	PixelKernels::seedParticles(pix.getData(), attr.getData(), simRes_.x, simRes_.y, seed);
+	for(auto &fbo : ping_) {
+		fbo.getTexture(0).loadData(pix);
+		fbo.getTexture(1).loadData(attr);
+	}
 	particlesReady_ = true;
 	if(simRes_ != lastInitRes_) {
 		ofLogNotice("NEXT2VISUALS") << "Particles initialized: " << simRes_.x << " x " << simRes_.y;
@@ -584,14 +673,21 @@ void ofApp::initParticles(){
 //--------------------------------------------------------------
 void ofApp::updateParticles(float dt){
 	if(!shadersLoaded_) return;
+	if(interact_) {
+		binParticles();
+	}
+	auto timed = stageTimer_.scope("simulate");
+	++simStep_;
 
 	bool maskReady = texture_.isAllocated();
 	bool useMask = collide_ && maskReady;
 
 	ping_[1 - curPing_].begin();
+	ping_[1 - curPing_].activateAllDrawBuffers();
 	ofClear(0,0,0,0);
 	updateShader_.begin();
-	updateShader_.setUniformTexture("posTex", ping_[curPing_].getTexture(), 0);
+	updateShader_.setUniformTexture("posTex", ping_[curPing_].getTexture(0), 0);
+	updateShader_.setUniformTexture("attrTex", ping_[curPing_].getTexture(1), 4);
 	if(maskReady) {
 		updateShader_.setUniformTexture("maskTex", texture_, 1);
 	} else {
@@ -610,7 +706,20 @@ void ofApp::updateParticles(float dt){
 	updateShader_.setUniform1f("bounceDampen", bounceDampen_);
 	updateShader_.setUniform1f("bounceNoise", bounceNoise_);
 	updateShader_.setUniform1f("killFraction", killFraction_);
-	updateShader_.setUniform1f("time", ofGetElapsedTimef());
+	updateShader_.setUniform1i("frame", simStep_);
+	updateShader_.setUniform1i("interact", interact_ ? 1 : 0);
+	if(interact_) {
+		updateShader_.setUniformTexture("gridSum", gridFbo_.getTexture(0), 2);
+		updateShader_.setUniformTexture("gridVel", gridFbo_.getTexture(1), 3);
+		updateShader_.setUniform2f("gridRes", gridRes_.x, gridRes_.y);
+		updateShader_.setUniform1f("cellSize", interactRadius_);
+		updateShader_.setUniform1f("repulsion", repulsion_);
+		updateShader_.setUniform1f("cohesion", cohesion_);
+		updateShader_.setUniform1f("alignment", alignment_);
+	} else {
+		updateShader_.setUniformTexture("gridSum", ping_[curPing_].getTexture(), 2);
+		updateShader_.setUniformTexture("gridVel", ping_[curPing_].getTexture(), 3);
+	}
 	ping_[curPing_].draw(0,0);
 	updateShader_.end();
 	ping_[1 - curPing_].end();
@@ -618,6 +727,151 @@ void ofApp::updateParticles(float dt){
 	curPing_ = 1 - curPing_;
 }
 
+//--------------------------------------------------------------
+void ofApp::ensureGridFbo(){
+	// one cell per interaction radius, so the 3x3 neighbourhood covers it
+	glm::ivec2 res(std::ceil(ofGetWidth() / interactRadius_), std::ceil(ofGetHeight() / interactRadius_));
+	if(gridFbo_.isAllocated() && res == gridRes_) return;
+	gridRes_ = res;
+
+	ofFbo::Settings s;
+	s.width = gridRes_.x;
+	s.height = gridRes_.y;
+	s.internalformat = GL_RGBA32F;
+	s.numColorbuffers = 2;
+	s.useDepth = false;
+	s.useStencil = false;
+	s.textureTarget = GL_TEXTURE_2D;
+	s.minFilter = GL_NEAREST;
+	s.maxFilter = GL_NEAREST;
+	s.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
+	s.wrapModeVertical = GL_CLAMP_TO_EDGE;
+	gridFbo_.allocate(s);
+	ofLogNotice("NEXT2VISUALS") << "Neighbour grid: " << gridRes_.x << " x " << gridRes_.y;
+}
+
+//--------------------------------------------------------------
+void ofApp::binParticles(){
+	auto timed = stageTimer_.scope("neighbours");
+	ensureGridFbo();
+
+	gridFbo_.begin();
+	gridFbo_.activateAllDrawBuffers();
+	ofClear(0,0,0,0);
+	ofPushStyle();
+	ofEnableBlendMode(OF_BLENDMODE_ADD);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	binShader_.begin();
+	binShader_.setUniformTexture("posTex", ping_[curPing_].getTexture(), 0);
+	binShader_.setUniform2f("screenRes", ofGetWidth(), ofGetHeight());
+	binShader_.setUniform2f("gridRes", gridRes_.x, gridRes_.y);
+	binShader_.setUniform1f("cellSize", interactRadius_);
+	particleMesh_.draw();
+	binShader_.end();
+	glDisable(GL_PROGRAM_POINT_SIZE);
+	ofDisableBlendMode();
+	ofPopStyle();
+	gridFbo_.end();
+}
+
+//--------------------------------------------------------------
+ofJson ofApp::checkNeighbourGrid(){
+	// GPU grid and forces vs the CPU reference over the same particle state.
+	// Steps the simulation once, so only call it at the end of a bench case
+	ofFloatPixels state, gpuSum, gpuVel;
+	ping_[curPing_].readToPixels(state);
+	binParticles();
+	gridFbo_.getTexture(0).readToPixels(gpuSum);
+	gridFbo_.getTexture(1).readToPixels(gpuVel);
+
+	SpatialHash hash;
+	std::vector<float> cpuSum, cpuVel;
+	const size_t count = size_t(simRes_.x) * simRes_.y;
+	std::vector<float> buildMs;
+	for(int i = 0; i < 5; ++i) {
+		auto start = ofGetElapsedTimeMicros();
+		hash.build(state.getData(), count, ofGetWidth(), ofGetHeight(), interactRadius_);
+		buildMs.push_back((ofGetElapsedTimeMicros() - start) / 1000.0f);
+	}
+	hash.cellMoments(cpuSum, cpuVel);
+
+	float countErr = 0.0f, posErr = 0.0f, velErr = 0.0f;
+	if(gpuSum.size() == cpuSum.size() && gpuVel.size() == cpuVel.size()) {
+		for(size_t i = 0; i < cpuSum.size(); i += 4) {
+			countErr = std::max(countErr, std::abs(gpuSum[i] - cpuSum[i]));
+			countErr = std::max(countErr, std::abs(gpuVel[i + 3] - cpuVel[i + 3]));
+			// relative to the cell size: summation order differs
+			float n = std::max(1.0f, cpuSum[i]);
+			posErr = std::max(posErr, std::abs(gpuSum[i + 1] - cpuSum[i + 1]) / n);
+			posErr = std::max(posErr, std::abs(gpuSum[i + 2] - cpuSum[i + 2]) / n);
+			velErr = std::max(velErr, std::abs(gpuVel[i + 0] - cpuVel[i + 0]) / n);
+			velErr = std::max(velErr, std::abs(gpuVel[i + 1] - cpuVel[i + 1]) / n);
+		}
+	} else {
+		countErr = std::numeric_limits<float>::max();
+	}
+
+	// forces: one GPU step with gravity, noise and mask collisions off, so
+	// update.frag leaves v1 = (v0 + F dt) * 0.99 and F can be read back
+	std::vector<float> cpuForce;
+	hash.computeForces(repulsion_, cohesion_, alignment_, cpuForce);
+	const float gravity = gravity_, noise = noiseStrength_;
+	const bool collide = collide_;
+	gravity_ = 0.0f;
+	noiseStrength_ = 0.0f;
+	collide_ = false;
+	updateParticles(options_.dt);
+	gravity_ = gravity;
+	noiseStrength_ = noise;
+	collide_ = collide;
+	ofFloatPixels next;
+	ping_[curPing_].readToPixels(next);
+
+	const float w = ofGetWidth(), h = ofGetHeight();
+	size_t forcesChecked = 0, forceMismatches = 0;
+	std::vector<float> forceErr;
+	if(next.size() == state.size()) {
+		forceErr.reserve(count);
+		for(size_t i = 0; i < count; ++i) {
+			const float *v0 = &state[i * 4 + 2];
+			const float *v1 = &next[i * 4 + 2];
+			// respawned or hit the velocity clamp: the force isn't recoverable
+			if(v1[0] == 0.0f && v1[1] == 0.0f) continue;
+			if(std::abs(v1[0]) >= 2.499f || v1[1] >= 3.499f || v1[1] <= -2.999f) continue;
+			float gx = (v1[0] / 0.99f - v0[0]) / options_.dt * w;
+			float gy = (v1[1] / 0.99f - v0[1]) / options_.dt * h;
+			float cx = cpuForce[i * 2 + 0], cy = cpuForce[i * 2 + 1];
+			float err = std::hypot(gx - cx, gy - cy);
+			// float readback of v, and cell sums added in a different order
+			if(err > 1.0f + 0.01f * std::hypot(cx, cy)) ++forceMismatches;
+			forceErr.push_back(err);
+			++forcesChecked;
+		}
+	}
+	float forceErrP99 = std::numeric_limits<float>::max();
+	if(!forceErr.empty()) {
+		auto p99 = forceErr.begin() + forceErr.size() * 99 / 100;
+		std::nth_element(forceErr.begin(), p99, forceErr.end());
+		forceErrP99 = *p99;
+	}
+	// a particle sitting on a cell border can land in the other cell on the
+	// GPU; allow a handful of those
+	const float mismatchFraction = forcesChecked ? float(forceMismatches) / forcesChecked : 1.0f;
+
+	std::sort(buildMs.begin(), buildMs.end());
+	ofJson j;
+	j["grid"] = {gridRes_.x, gridRes_.y};
+	j["max_count_error"] = countErr;
+	j["max_centroid_error_px"] = posErr;
+	j["max_mean_velocity_error_px"] = velErr;
+	j["forces_checked"] = forcesChecked;
+	j["force_p99_error_px_s2"] = forceErrP99;
+	j["force_mismatch_fraction"] = mismatchFraction;
+	j["cpu_build_ms"] = buildMs[buildMs.size() / 2];
+	j["ok"] = countErr < 0.5f && posErr < 0.05f && velErr < 0.05f && mismatchFraction < 0.001f;
+	return j;
+}
+
 //--------------------------------------------------------------
 void ofApp::drawCascade(){
 	if(!shadersLoaded_) return;
@@ -627,11 +881,12 @@ void ofApp::drawCascade(){
 	glEnable(GL_PROGRAM_POINT_SIZE);
 	glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
 	renderShader_.begin();
-	renderShader_.setUniformTexture("posTex", ping_[curPing_].getTexture(), 0);
+	renderShader_.setUniformTexture("posTex", ping_[curPing_].getTexture(0), 0);
+	renderShader_.setUniformTexture("attrTex", ping_[curPing_].getTexture(1), 1);
 	renderShader_.setUniform2f("posRes", simRes_.x, simRes_.y);
 	renderShader_.setUniform2f("screenRes", ofGetWidth(), ofGetHeight());
 	renderShader_.setUniform1f("pointSize", pointSize_);
-	renderShader_.setUniform1f("time", ofGetElapsedTimef());
+	renderShader_.setUniform1i("frame", simStep_);
 	renderShader_.setUniform1f("shrinkStrength", shrinkStrength_);
 	renderShader_.setUniform1i("renderSquares", renderSquares_ ? 1 : 0);
 	particleMesh_.draw();
@@ -640,3 +895,376 @@ void ofApp::drawCascade(){
 	ofDisablePointSprites();
 	ofPopStyle();
 }
+
+//--------------------------------------------------------------
+void ofApp::updateTrail(){
+	auto timed = stageTimer_.scope("trail");
+	trailFbo_.begin();
+	ofPushStyle();
+	ofEnableBlendMode(OF_BLENDMODE_ALPHA);
+	ofSetColor(0, 0, 0, static_cast<int>(trailFade_ * 255));
+	ofDrawRectangle(0, 0, trailFbo_.getWidth(), trailFbo_.getHeight());
+	ofSetColor(255);
+	drawCascade();
+	ofDisableBlendMode();
+	ofPopStyle();
+	trailFbo_.end();
+}
+
+//--------------------------------------------------------------
+void ofApp::setupOutputs(){
+	outputs_.clear();
+	outputsNeedMipmaps_ = false;
+	for(const auto &settings : NDIOutput::loadSettings(ofToDataPath("ndi_outputs.json"), ndiName_)) {
+		outputs_.push_back(std::make_unique<NDIOutput>(settings));
+		auto &output = *outputs_.back();
+		outputsNeedMipmaps_ |= output.needsMipmaps();
+		if(sendNDI_ && output.setupSender()) {
+			ndiReady_ = true;
+			ofLogNotice("NEXT2VISUALS") << "NDI output ready: " << settings.name;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::composeOutput(){
+	auto timed = stageTimer_.scope("compose");
+	outputFbo_.begin();
+	ofClear(0,0,0,0); // keep transparency
+	ofSetColor(255);
+	// draw trail
+	ofEnableBlendMode(OF_BLENDMODE_ALPHA);
+	trailFbo_.draw(0, 0, outputFbo_.getWidth(), outputFbo_.getHeight());
+	// draw fresh cascade on top
+	drawCascade();
+	ofDisableBlendMode();
+	outputFbo_.end();
+}
+
+//--------------------------------------------------------------
+void ofApp::publishOutput(){
+	composeOutput();
+	// one composite, then every output scales and reads back its own copy;
+	// frames come back a couple of draws later from the readback rings
+	{
+		auto timed = stageTimer_.scope("downsample");
+		const uint64_t frame = ofGetFrameNum();
+		// outputs without a sender only cost time, except when benching
+		auto captures = [&](const NDIOutput &output){
+			return output.wantsFrame(frame) && (output.isSending() || options_.isBench());
+		};
+		// the mip chain only feeds scaled outputs that capture this frame
+		bool mipmaps = false;
+		for(auto &output : outputs_) {
+			mipmaps |= output->needsMipmaps() && captures(*output);
+		}
+		if(mipmaps) {
+			outputFbo_.getTexture().generateMipmap();
+		}
+		for(auto &output : outputs_) {
+			output->resize(outputFbo_.getWidth(), outputFbo_.getHeight());
+			if(captures(*output)) {
+				output->capture(outputFbo_.getTexture());
+			}
+		}
+	}
+	std::vector<NDIOutput *> received;
+	{
+		auto timed = stageTimer_.scope("readback");
+		for(auto &output : outputs_) {
+			if(output->receive()) received.push_back(output.get());
+		}
+	}
+	{
+		auto timed = stageTimer_.scope("post");
+		for(auto *output : received) {
+			prepareOutputPixels(output->getPixels());
+		}
+	}
+	if(ndiReady_) {
+		auto timed = stageTimer_.scope("send");
+		for(auto *output : received) {
+			output->send();
+		}
+	}
+}
+
+//--------------------------------------------------------------
+bool ofApp::openMaskSource(){
+	if(options_.maskPath.empty()) return true;
+
+	ofFile maskFile(options_.maskPath);
+	if(maskFile.isDirectory()) {
+		ofDirectory dir(options_.maskPath);
+		for(auto ext : {"png", "jpg", "jpeg", "tif", "tiff", "bmp", "exr"}) {
+			dir.allowExt(ext);
+		}
+		dir.listDir();
+		dir.sort();
+		for(size_t i = 0; i < dir.size(); ++i) {
+			maskFrames_.push_back(dir.getPath(i));
+		}
+		if(maskFrames_.empty()) {
+			ofLogError("NEXT2VISUALS") << "no mask images in " << options_.maskPath;
+			return false;
+		}
+	} else if(maskFile.exists() && maskVideo_.load(options_.maskPath)) {
+		maskVideo_.setLoopState(OF_LOOP_NONE);
+		maskVideo_.setPaused(true);
+	} else {
+		ofLogError("NEXT2VISUALS") << "can't open masks: " << options_.maskPath;
+		return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+bool ofApp::setupOffline(){
+	if(!shadersLoaded_ || !openMaskSource()) return false;
+
+	offlineFrameCount_ = options_.frames;
+	if(offlineFrameCount_ == 0) {
+		offlineFrameCount_ = maskVideo_.isLoaded() ? maskVideo_.getTotalNumFrames() : int(maskFrames_.size());
+	}
+	if(offlineFrameCount_ <= 0) {
+		ofLogError("NEXT2VISUALS") << "nothing to render, pass --frames";
+		return false;
+	}
+
+	if(!frameWriter_.setup(options_.outDir, options_.format, options_.encoderThreads)) {
+		return false;
+	}
+	frameWriter_.setPrepare(prepareOutputPixels);
+	frameWriter_.setPrepareFloat(prepareOutputFloatPixels);
+
+	ensureTrailFbo();
+	ensureOutputFbo();
+	offlineReadback_.allocate(outputFbo_.getWidth(), outputFbo_.getHeight(), 3, canvasFormat_ != GL_RGBA);
+	offlineStartMs_ = ofGetElapsedTimeMillis();
+	ofLogNotice("NEXT2VISUALS") << "offline render: " << offlineFrameCount_ << " frames at dt " << options_.dt
+		<< " -> " << options_.outDir << " (" << options_.format << ", " << frameWriter_.numThreads() << " encoder threads)";
+	return true;
+}
+
+//--------------------------------------------------------------
+bool ofApp::fetchMask(int frame){
+	if(maskVideo_.isLoaded()) {
+		// past the end of the video the last mask stays up
+		bool step = maskRewound_ || (frame > 0 && maskVideo_.getCurrentFrame() < maskVideo_.getTotalNumFrames() - 1);
+		maskRewound_ = false;
+		if(frame > 0 && step) {
+			maskVideo_.nextFrame();
+		}
+		// nextFrame() / firstFrame() only start a seek on the paused player;
+		// wait for the decoded frame instead of taking the previous one again
+		maskVideo_.update();
+		if(step || !maskVideo_.getPixels().isAllocated()) {
+			uint64_t start = ofGetElapsedTimeMillis();
+			while(!maskVideo_.isFrameNew()) {
+				if(ofGetElapsedTimeMillis() - start > kMaskDecodeTimeoutMs) {
+					ofLogError("NEXT2VISUALS") << "mask video frame " << frame << " didn't decode within "
+						<< kMaskDecodeTimeoutMs << " ms";
+					maskFailed_ = true;
+					return false;
+				}
+				ofSleepMillis(1);
+				maskVideo_.update();
+			}
+		}
+		pixels_ = maskVideo_.getPixels();
+		return pixels_.isAllocated();
+	}
+	if(maskFrames_.empty()) return false;
+
+	// decode the next image while this step simulates
+	auto load = [](std::string path){
+		ofPixels pix;
+		if(!ofLoadImage(pix, path)) {
+			ofLogError("NEXT2VISUALS") << "can't load mask " << path;
+		}
+		return pix;
+	};
+	// past the last image it stays up, like the last frame of a video
+	const int last = int(maskFrames_.size()) - 1;
+	const auto &path = maskFrames_[std::min(frame, last)];
+	pixels_ = nextMask_.valid() ? nextMask_.get() : load(path);
+	const auto &nextPath = maskFrames_[std::min(frame + 1, last)];
+	nextMask_ = std::async(std::launch::async, load, nextPath);
+	return pixels_.isAllocated();
+}
+
+//--------------------------------------------------------------
+void ofApp::uploadMask(const ofPixels &pix){
+	if(!pix.isAllocated()) return;
+	auto timed = stageTimer_.scope("mask");
+	if(!texture_.isAllocated() || texture_.getWidth() != pix.getWidth() || texture_.getHeight() != pix.getHeight()) {
+		texture_.allocate(pix);
+	}
+	texture_.loadData(pix);
+	hasFrame_ = true;
+}
+
+//--------------------------------------------------------------
+void ofApp::drawOffline(){
+	if(!particlesReady_ || offlineDone_) return;
+
+	updateTrail();
+	composeOutput();
+
+	// queue this frame's readback and hand any landed frames to the encoders
+	offlineReadback_.push(outputFbo_.getTexture());
+	drainOfflineReadback(false);
+
+	++offlineFrame_;
+	if(offlineFrame_ % 100 == 0) {
+		float secs = (ofGetElapsedTimeMillis() - offlineStartMs_) / 1000.0f;
+		ofLogNotice("NEXT2VISUALS") << "rendered " << offlineFrame_ << "/" << offlineFrameCount_
+			<< " (" << ofToString(offlineFrame_ / std::max(secs, 0.001f), 1) << " fps)";
+	}
+	if(offlineFrame_ >= offlineFrameCount_) {
+		finishOffline();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::drainOfflineReadback(bool wait){
+	if(offlineReadback_.isFloat()) {
+		ofFloatPixels frame;
+		while(offlineReadback_.pop(frame, wait)) {
+			frameWriter_.write(std::move(frame), offlineFramesRead_++);
+		}
+		return;
+	}
+	ofPixels frame;
+	while(offlineReadback_.pop(frame, wait)) {
+		frameWriter_.write(std::move(frame), offlineFramesRead_++);
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::finishOffline(){
+	if(offlineDone_) return;
+	offlineDone_ = true;
+
+	drainOfflineReadback(true);
+	frameWriter_.finish();
+
+	float secs = (ofGetElapsedTimeMillis() - offlineStartMs_) / 1000.0f;
+	ofLogNotice("NEXT2VISUALS") << "offline render done: " << frameWriter_.framesWritten() << " frames in "
+		<< ofToString(secs, 2) << "s (" << ofToString(frameWriter_.framesWritten() / std::max(secs, 0.001f), 1) << " fps)";
+	if(frameWriter_.framesFailed() > 0) {
+		ofLogError("NEXT2VISUALS") << frameWriter_.framesFailed() << " frames failed to write to " << options_.outDir;
+		ofExit(1);
+		return;
+	}
+	ofExit(0);
+}
+
+//--------------------------------------------------------------
+bool ofApp::setupBench(){
+	if(!shadersLoaded_ || !openMaskSource()) return false;
+
+	auto configPath = options_.benchConfig.empty() ? ofToDataPath("bench/cases.json", true) : options_.benchConfig;
+	if(!bench_.setup(configPath)) return false;
+	if(options_.tolerance >= 0.0f) {
+		bench_.setTolerance(options_.tolerance);
+	}
+	stageTimer_.setEnabled(true);
+	startBenchCase(0);
+	return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::startBenchCase(int index){
+	const auto &benchCase = bench_.getCases()[index];
+	benchCase_ = index;
+	benchFrame_ = 0;
+
+	if(ofGetWidth() != benchCase.width || ofGetHeight() != benchCase.height) {
+		ofSetWindowShape(benchCase.width, benchCase.height);
+	}
+	// same seed and clock for every case so runs are comparable
+	ofSeedRandom(options_.seed);
+	simStep_ = 0;
+	simDensity_ = benchCase.density;
+	interact_ = benchCase.interact;
+	computeSimRes();
+	rebuildCascade();
+	ensureTrailFbo();
+	ensureOutputFbo();
+	for(auto &output : outputs_) {
+		output->clear(); // drop frames still in flight from the last case
+	}
+	// every case sees the mask sequence from its first frame
+	if(maskVideo_.isLoaded()) {
+		maskVideo_.firstFrame();
+		maskRewound_ = true;
+	}
+	nextMask_ = std::future<ofPixels>(); // drop the last case's prefetch
+
+	stageTimer_.reset();
+	stageTimer_.setRecording(bench_.getWarmupFrames() == 0);
+	ofLogNotice("FrameBench") << "case " << benchCase.name << ": " << simRes_.x * simRes_.y << " particles";
+}
+
+//--------------------------------------------------------------
+void ofApp::makeSyntheticMask(int frame){
+	// a handful of soft-edged blobs drifting over the canvas, standing in for
+	// the silhouettes the NDI mask normally carries
+	int w = ofGetWidth();
+	int h = ofGetHeight();
+	if(!syntheticMask_.isAllocated() || int(syntheticMask_.getWidth()) != w || int(syntheticMask_.getHeight()) != h) {
+		syntheticMask_.allocate(w, h, OF_PIXELS_RGBA);
+	}
+	syntheticMask_.set(0);
+
+	auto *data = syntheticMask_.getData();
+	const float t = frame * 0.02f;
+	const float radius = w * 0.12f;
+	for(int k = 0; k < 5; ++k) {
+		float cx = w * (0.5f + 0.32f * std::sin(t + k * 1.3f));
+		float cy = h * (0.3f + 0.12f * k + 0.04f * std::cos(t * 1.7f + k));
+		int x0 = std::max(0, int(cx - radius)), x1 = std::min(w - 1, int(cx + radius));
+		int y0 = std::max(0, int(cy - radius)), y1 = std::min(h - 1, int(cy + radius));
+		for(int y = y0; y <= y1; ++y) {
+			for(int x = x0; x <= x1; ++x) {
+				float d = glm::length(glm::vec2(x - cx, y - cy)) / radius;
+				unsigned char v = static_cast<unsigned char>(255.0f * ofClamp((1.0f - d) * 4.0f, 0.0f, 1.0f));
+				auto *px = data + (size_t(y) * w + x) * 4;
+				px[0] = px[1] = px[2] = std::max(px[0], v);
+				px[3] = 255;
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::drawBench(){
+	if(benchCase_ < 0) return;
+
+	updateTrail();
+	drawScreen();
+	publishOutput();
+	stageTimer_.endFrame();
+
+	++benchFrame_;
+	if(benchFrame_ == bench_.getWarmupFrames()) {
+		stageTimer_.setRecording(true);
+	}
+	if(benchFrame_ < bench_.getWarmupFrames() + bench_.getMeasureFrames()) return;
+
+	ofJson extra;
+	if(interact_) {
+		stageTimer_.setRecording(false);
+		extra["neighbour_check"] = checkNeighbourGrid();
+	}
+	bench_.addResult(bench_.getCases()[benchCase_], simRes_, stageTimer_, extra);
+	if(benchCase_ + 1 < int(bench_.getCases().size())) {
+		startBenchCase(benchCase_ + 1);
+	} else {
+		benchCase_ = -1;
+		auto baselinePath = options_.baselinePath.empty() ? ofToDataPath("bench/baseline.json", true) : options_.baselinePath;
+		bool passed = bench_.finish(options_.benchOut, baselinePath, options_.updateBaseline);
+		ofExit(passed ? 0 : 1);
+	}
+}
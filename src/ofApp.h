@@ -7,10 +7,22 @@
 #include "ofxNDISender.h"
 #include "ofxNDISendStream.h"
 #include "ofxGui.h"
+#include "RunOptions.h"
+#include "AsyncReadback.h"
+#include "NDIOutput.h"
+#include "FrameWriter.h"
+#include "FrameBench.h"
+#include "StageTimer.h"
+#include "SpatialHash.h"
+#include "PixelKernels.h"
+
+#include <future>
 
 class ofApp : public ofBaseApp{
 
 	public:
+		explicit ofApp(const RunOptions &options = RunOptions()) : options_(options) {}
+
 		void setup() override;
 		void update() override;
 		void draw() override;
@@ -43,6 +55,27 @@ class ofApp : public ofBaseApp{
 		void initParticles();
 		void updateParticles(float dt);
 		void drawCascade();
+		void ensureGridFbo();
+		void binParticles();
+		ofJson checkNeighbourGrid();
+		void updateTrail();
+		void drawScreen();
+		void setupOutputs();
+		void composeOutput();
+		void publishOutput();
+		void uploadMask(const ofPixels &pix);
+
+		// offline render / bench
+		bool openMaskSource();
+		bool fetchMask(int frame);
+		bool setupOffline();
+		void drawOffline();
+		void drainOfflineReadback(bool wait);
+		void finishOffline();
+		bool setupBench();
+		void startBenchCase(int index);
+		void makeSyntheticMask(int frame);
+		void drawBench();
 
 		ofxNDIFinder finder_;
 		ofxNDIReceiver receiver_;
@@ -84,17 +117,52 @@ class ofApp : public ofBaseApp{
 		float bounceNoise_ = 0.35f;
 		float trailFade_ = 0.1f;
 
+		// Neighbour interaction (uniform grid of cell averages, off by default)
+		bool interact_ = false;
+		float interactRadius_ = 6.0f; // px, also the grid cell size
+		float repulsion_ = 300.0f;
+		float cohesion_ = 40.0f;  // pull toward neighbours, lets the flow clump
+		float alignment_ = 4.0f;  // velocity matching, lets it form streams
+		ofShader binShader_;
+		ofFbo gridFbo_; // 0: count + position sums, 1: velocity sums
+		glm::ivec2 gridRes_{0,0};
+
 		ofRectangle maskDrawRect_;
 		float simDensity_ = 0.15f; // particles per pixel on width (lighter)
 		glm::ivec2 lastInitRes_{0,0};
 		ofFbo trailFbo_;
 		ofFbo outputFbo_;
-		// NDI output
-		ofxNDISender ndiSender_;
-		ofxNDISendVideo ndiVideo_;
-		bool ndiReady_ = false;
+		GLint canvasFormat_ = GL_RGBA; // of trailFbo_ / outputFbo_, RGBA16F for exr
+		// NDI outputs, all cut from outputFbo_ (ndi_outputs.json)
+		std::vector<std::unique_ptr<NDIOutput>> outputs_;
+		bool outputsNeedMipmaps_ = false;
+		bool ndiReady_ = false; // at least one sender is up
 		bool sendNDI_ = true;
-		std::string ndiName_ = "NEXT2VISUALS Output";
+		std::string ndiName_ = "NEXT2VISUALS Output"; // default when there's no config
+
+		// Offline render (--offline), also used by --bench
+		RunOptions options_;
+		int simStep_ = 0; // RNG counter for the particle shaders; fixed-dt steps offline
+		std::vector<std::string> maskFrames_;
+		std::future<ofPixels> nextMask_;
+		ofVideoPlayer maskVideo_;
+		bool maskRewound_ = false; // firstFrame() seek not yet waited for
+		bool maskFailed_ = false;  // a video frame didn't decode in time
+		static constexpr uint64_t kMaskDecodeTimeoutMs = 2000;
+		int offlineFrame_ = 0;
+		int offlineFrameCount_ = 0;
+		size_t offlineFramesRead_ = 0; // frames back from the GPU, in order
+		bool offlineDone_ = false;
+		uint64_t offlineStartMs_ = 0;
+		AsyncReadback offlineReadback_;
+		FrameWriter frameWriter_;
+
+		// Frame-time bench (--bench)
+		FrameBench bench_;
+		StageTimer stageTimer_; // no-op unless benching
+		int benchCase_ = -1;
+		int benchFrame_ = 0;
+		ofPixels syntheticMask_;
 
 		// GUI
 		ofxPanel gui_;
@@ -115,5 +183,10 @@ class ofApp : public ofBaseApp{
 		ofParameter<bool> pInvertMask_;
 		ofParameter<bool> pShowMask_;
 		ofParameter<bool> pRenderSquares_;
+		ofParameter<bool> pInteract_;
+		ofParameter<float> pInteractRadius_;
+		ofParameter<float> pRepulsion_;
+		ofParameter<float> pCohesion_;
+		ofParameter<float> pAlignment_;
 		
 };
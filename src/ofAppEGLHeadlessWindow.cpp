@@ -0,0 +1,233 @@
+#include "ofAppEGLHeadlessWindow.h"
+
+#if defined(TARGET_LINUX) && !defined(TARGET_OPENGLES)
+
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace {
+
+bool hasExtension(const char *list, const char *name){
+	if(!list) return false;
+	size_t len = std::strlen(name);
+	for(const char *p = list; (p = std::strstr(p, name)) != nullptr; p += len) {
+		if((p == list || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) return true;
+	}
+	return false;
+}
+
+EGLDisplay openDisplay(){
+	// surfaceless first: it never touches X or DRM nodes, which is what a
+	// render node or container usually lacks
+	const char *clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if(hasExtension(clientExts, "EGL_MESA_platform_surfaceless")) {
+		auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if(getPlatformDisplay) {
+			EGLDisplay dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if(dpy != EGL_NO_DISPLAY && eglInitialize(dpy, nullptr, nullptr)) return dpy;
+		}
+	}
+	EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if(dpy != EGL_NO_DISPLAY && eglInitialize(dpy, nullptr, nullptr)) return dpy;
+	return EGL_NO_DISPLAY;
+}
+
+}
+
+//--------------------------------------------------------------
+ofAppEGLHeadlessWindow::ofAppEGLHeadlessWindow(){
+	renderer_ = std::make_shared<ofGLProgrammableRenderer>(this);
+}
+
+//--------------------------------------------------------------
+ofAppEGLHeadlessWindow::~ofAppEGLHeadlessWindow(){
+	close();
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::setup(const ofGLWindowSettings &settings){
+	width_ = settings.getWidth();
+	height_ = settings.getHeight();
+
+	if(!createContext(settings)) {
+		ofLogFatalError("ofAppEGLHeadlessWindow") << "couldn't create an EGL OpenGL "
+			<< settings.glVersionMajor << "." << settings.glVersionMinor << " core context";
+		std::exit(1);
+	}
+
+	// OF's GLEW resolves through libglvnd, which dispatches to whichever
+	// context is current, EGL included
+	glewExperimental = GL_TRUE;
+	GLenum err = glewInit();
+	if(err != GLEW_OK) {
+		ofLogError("ofAppEGLHeadlessWindow") << "glewInit: " << glewGetErrorString(err);
+	}
+	glGetError(); // glewInit trips GL_INVALID_ENUM on core profiles
+
+	std::static_pointer_cast<ofGLProgrammableRenderer>(renderer_)->setup(settings.glVersionMajor, settings.glVersionMinor);
+	ofLogNotice("ofAppEGLHeadlessWindow") << "GL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER)
+		<< " (" << width_ << "x" << height_ << ")";
+}
+
+//--------------------------------------------------------------
+bool ofAppEGLHeadlessWindow::createContext(const ofGLWindowSettings &settings){
+	EGLDisplay dpy = openDisplay();
+	if(dpy == EGL_NO_DISPLAY) return false;
+	display_ = dpy;
+
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint numConfigs = 0;
+	if(!eglChooseConfig(dpy, configAttribs, &config, 1, &numConfigs) || numConfigs < 1) return false;
+	config_ = config;
+
+	if(!eglBindAPI(EGL_OPENGL_API)) return false;
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, settings.glVersionMajor,
+		EGL_CONTEXT_MINOR_VERSION_KHR, settings.glVersionMinor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, contextAttribs);
+	if(ctx == EGL_NO_CONTEXT) return false;
+	context_ = ctx;
+
+	if(!createSurface(width_, height_)) {
+		// no pbuffer support: fine as long as the context can go surfaceless,
+		// since everything we keep is rendered into FBOs
+		if(!hasExtension(eglQueryString(dpy, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) return false;
+		ofLogWarning("ofAppEGLHeadlessWindow") << "no pbuffer, running surfaceless";
+	}
+	makeCurrent();
+	return eglGetCurrentContext() == ctx;
+}
+
+//--------------------------------------------------------------
+bool ofAppEGLHeadlessWindow::createSurface(int w, int h){
+	if(surface_) {
+		eglDestroySurface(display_, surface_);
+		surface_ = nullptr;
+	}
+	const EGLint pbufferAttribs[] = {
+		EGL_WIDTH, std::max(1, w),
+		EGL_HEIGHT, std::max(1, h),
+		EGL_NONE
+	};
+	EGLSurface surface = eglCreatePbufferSurface(display_, config_, pbufferAttribs);
+	if(surface == EGL_NO_SURFACE) return false;
+	surface_ = surface;
+	return true;
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::update(){
+	coreEvents_.notifyUpdate();
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::draw(){
+	renderer_->startRender();
+	renderer_->setupScreen();
+	coreEvents_.notifyDraw();
+	renderer_->finishRender();
+	swapBuffers();
+}
+
+//--------------------------------------------------------------
+bool ofAppEGLHeadlessWindow::getWindowShouldClose(){
+	return shouldClose_;
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::setWindowShouldClose(){
+	shouldClose_ = true;
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::close(){
+	if(!display_) return;
+	eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if(surface_) eglDestroySurface(display_, surface_);
+	if(context_) eglDestroyContext(display_, context_);
+	eglTerminate(display_);
+	surface_ = nullptr;
+	context_ = nullptr;
+	display_ = nullptr;
+	coreEvents_.disable();
+}
+
+//--------------------------------------------------------------
+ofCoreEvents & ofAppEGLHeadlessWindow::events(){
+	return coreEvents_;
+}
+
+//--------------------------------------------------------------
+std::shared_ptr<ofBaseRenderer> & ofAppEGLHeadlessWindow::renderer(){
+	return renderer_;
+}
+
+//--------------------------------------------------------------
+glm::vec2 ofAppEGLHeadlessWindow::getWindowSize(){
+	return {width_, height_};
+}
+
+//--------------------------------------------------------------
+glm::vec2 ofAppEGLHeadlessWindow::getScreenSize(){
+	return {width_, height_};
+}
+
+//--------------------------------------------------------------
+int ofAppEGLHeadlessWindow::getWidth(){
+	return width_;
+}
+
+//--------------------------------------------------------------
+int ofAppEGLHeadlessWindow::getHeight(){
+	return height_;
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::setWindowShape(int w, int h){
+	if(w == width_ && h == height_) return;
+	width_ = w;
+	height_ = h;
+	if(surface_ && createSurface(w, h)) {
+		makeCurrent();
+	}
+	coreEvents_.notifyWindowResized(w, h);
+}
+
+//--------------------------------------------------------------
+ofWindowMode ofAppEGLHeadlessWindow::getWindowMode(){
+	return OF_WINDOW;
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::makeCurrent(){
+	EGLSurface surface = surface_ ? surface_ : EGL_NO_SURFACE;
+	eglMakeCurrent(display_, surface, surface, context_);
+}
+
+//--------------------------------------------------------------
+void ofAppEGLHeadlessWindow::swapBuffers(){
+	// nothing is presented; keep the queue moving like a real swap would
+	glFlush();
+}
+
+#endif
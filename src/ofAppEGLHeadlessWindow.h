@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ofMain.h"
+
+#if defined(TARGET_LINUX) && !defined(TARGET_OPENGLES)
+
+// Offscreen GL window for render nodes and CI boxes. The core profile context
+// comes from EGL on a pbuffer, preferring Mesa's surfaceless platform, so it
+// needs no X server and runs on llvmpipe when there is no GPU. All real output
+// goes through FBOs; the pbuffer only backs the default framebuffer.
+class ofAppEGLHeadlessWindow : public ofAppBaseGLWindow {
+	public:
+		ofAppEGLHeadlessWindow();
+		~ofAppEGLHeadlessWindow();
+
+		using ofAppBaseGLWindow::setup;
+		void setup(const ofGLWindowSettings &settings) override;
+		void update() override;
+		void draw() override;
+		bool getWindowShouldClose() override;
+		void setWindowShouldClose() override;
+		void close() override;
+
+		ofCoreEvents & events() override;
+		std::shared_ptr<ofBaseRenderer> & renderer() override;
+
+		glm::vec2 getWindowSize() override;
+		glm::vec2 getScreenSize() override;
+		int getWidth() override;
+		int getHeight() override;
+		void setWindowShape(int w, int h) override;
+		ofWindowMode getWindowMode() override;
+
+		void makeCurrent() override;
+		void swapBuffers() override;
+
+	private:
+		bool createContext(const ofGLWindowSettings &settings);
+		bool createSurface(int w, int h);
+
+		// EGL handles kept opaque so EGL/X11 headers stay out of the app
+		void *display_ = nullptr;
+		void *config_ = nullptr;
+		void *context_ = nullptr;
+		void *surface_ = nullptr;
+
+		int width_ = 0;
+		int height_ = 0;
+		bool shouldClose_ = false;
+
+		ofCoreEvents coreEvents_;
+		std::shared_ptr<ofBaseRenderer> renderer_;
+};
+
+#endif